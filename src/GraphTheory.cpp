@@ -6,6 +6,7 @@
 #include <stack>
 #include <set>
 #include <queue>
+#include <unordered_set>
 #include "GraphTheory.h"
 
 namespace raven
@@ -77,6 +78,84 @@ namespace raven
             }
         }
 
+        void cSearchWorkspace::start(int vertexCount)
+        {
+            if (myVisited.size() < vertexCount)
+            {
+                // new entries get stamp 0, which is never a current generation
+                myVisited.resize(vertexCount, 0);
+                myPredStamp.resize(vertexCount, 0);
+                myDistStamp.resize(vertexCount, 0);
+                myPred.resize(vertexCount);
+                myDist.resize(vertexCount);
+            }
+            myWait.clear();
+
+            myGeneration++;
+            if (myGeneration == 0)
+            {
+                // generation counter wrapped around
+                // clear the stamps so that no stale entry matches
+                std::fill(myVisited.begin(), myVisited.end(), 0);
+                std::fill(myPredStamp.begin(), myPredStamp.end(), 0);
+                std::fill(myDistStamp.begin(), myDistStamp.end(), 0);
+                myGeneration = 1;
+            }
+        }
+
+        void dijsktra(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int end,
+            cSearchWorkspace &work)
+        {
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "dijsktra bad edge weights");
+            if (start < 0 || start >= g.vertexCount())
+                throw std::runtime_error(
+                    "dijsktra bad start");
+
+            work.start(g.vertexCount());
+
+            // vertices waiting to be finalized, nearest at top
+            typedef std::pair<double, int> dv_t;
+            std::priority_queue<dv_t, std::vector<dv_t>, std::greater<dv_t>> Q;
+
+            work.dist(start, 0);
+            Q.push(std::make_pair(0, start));
+
+            while (!Q.empty())
+            {
+                int u = Q.top().second;
+                double d = Q.top().first;
+                Q.pop();
+
+                // skip entries superseded by a shorter path
+                if (work.isVisited(u))
+                    continue;
+
+                // shortest distance to u is final
+                work.visit(u);
+                if (u == end)
+                    break;
+
+                for (int v : g.adjacentOutRef(u))
+                {
+                    if (work.isVisited(v))
+                        continue;
+                    double cost = d + edgeWeight[g.find(u, v)];
+                    if (cost < work.dist(v))
+                    {
+                        work.dist(v, cost);
+                        work.pred(v, u);
+                        Q.push(std::make_pair(cost, v));
+                    }
+                }
+            }
+        }
+
         std::pair<std::vector<int>, double>
         path(sGraphData &gd)
         {
@@ -187,107 +266,200 @@ namespace raven
             return std::make_pair(vpath, dist[end]);
         }
 
-        static void combine_yen(
-            path_cost_t &spur,
-            const path_cost_t &prev,
-            int rootlength,
-            const sGraphData &gd)
+        size_t sPathHash::operator()(const path_t &p) const
         {
-            spur.first.insert(
-                spur.first.begin(),
-                prev.first.begin(), prev.first.begin() + rootlength - 1);
-            spur.second = 0;
-            for (int v = 1; v < spur.first.size(); v++)
-                spur.second += gd.edgeWeight[gd.g.find(
-                    spur.first[v - 1], spur.first[v])];
+            size_t h = p.size();
+            for (int v : p)
+                h ^= std::hash<int>()(v) + 0x9e3779b9 + (h << 6) + (h >> 2);
+            return h;
         }
-        static bool isNewPath_yen(
-            const path_cost_t &test,
-            const vPath_t &vShortestPaths)
+
+        /// @brief shortest path from spur to end, avoiding masked vertices and links
+        /// @param gd graph data
+        /// @param spur vertex index to start from
+        /// @param end vertex index to reach
+        /// @param vBlocked true for vertices on the root path that must not be used
+        /// @param vBlockedNext vertices that cannot be reached by one hop from the spur
+        /// @return spur path, empty if end is unreachable, and its cost
+        ///
+        /// The input graph is not modified, the masks overlay it.
+        /// Algorithm: Dijsktra with a binary heap
+
+        static path_cost_t spur_yen(
+            const sGraphData &gd,
+            int spur,
+            int end,
+            const std::vector<bool> &vBlocked,
+            const std::vector<int> &vBlockedNext)
         {
-            return (
-                std::find_if(
-                    vShortestPaths.begin(), vShortestPaths.end(),
-                    [&](const path_cost_t &p)
+            path_cost_t ret;
+            ret.second = -1;
+
+            std::vector<double> dist(gd.g.vertexCount(), INT_MAX);
+            std::vector<int> pred(gd.g.vertexCount(), -1);
+
+            typedef std::pair<double, int> dv_t;
+            std::priority_queue<dv_t, std::vector<dv_t>, std::greater<dv_t>> Q;
+
+            dist[spur] = 0;
+            Q.push(std::make_pair(0, spur));
+
+            while (!Q.empty())
+            {
+                auto top = Q.top();
+                Q.pop();
+                int u = top.second;
+                if (top.first > dist[u])
+                    continue; // stale queue entry
+                if (u == end)
+                    break;
+
+                for (int v : gd.g.adjacentOut(u))
+                {
+                    if (vBlocked[v])
+                        continue;
+                    if (u == spur &&
+                        std::find(vBlockedNext.begin(), vBlockedNext.end(), v) != vBlockedNext.end())
+                        continue;
+
+                    double d = dist[u] + gd.edgeWeight[gd.g.find(u, v)];
+                    if (d < dist[v])
                     {
-                        return std::equal(
-                            p.first.begin(), p.first.end(),
-                            test.first.begin());
-                    }) == vShortestPaths.end());
+                        dist[v] = d;
+                        pred[v] = u;
+                        Q.push(std::make_pair(d, v));
+                    }
+                }
+            }
+
+            if (end != spur && pred[end] == -1)
+                return ret;
+
+            for (int v = end; v != spur; v = pred[v])
+                ret.first.push_back(v);
+            ret.first.push_back(spur);
+            std::reverse(ret.first.begin(), ret.first.end());
+            ret.second = dist[end];
+            return ret;
         }
 
-        vPath_t
-        allPaths(sGraphData &gd)
+        cKShortestPaths::cKShortestPaths(sGraphData &gd)
+            : myGD(gd),
+              myEnd(-1),
+              myfStarted(false),
+              myCandidateCount(0)
         {
-            vPath_t vShortestPaths;
-            vPath_t vPotentialPaths;
-
             // Looking for all the paths, regardless of cost
-            // so set all link costs to 1
+            // so set all missing link costs to 1
 
             gd.edgeWeight.resize(gd.g.edgeCount(), 1);
+        }
 
-            // Dijsktra gives the very shortest path
+        path_cost_t cKShortestPaths::next()
+        {
+            path_cost_t ret;
+            ret.second = -1;
 
-            vShortestPaths.push_back(path(gd));
+            if (!myfStarted)
+            {
+                myfStarted = true;
+
+                // Dijsktra gives the very shortest path
+
+                ret = path(myGD);
+                if (!ret.first.size())
+                    return ret;
+                myEnd = ret.first.back();
+                vBlocked.resize(myGD.g.vertexCount(), false);
+                mySeen.insert(ret.first);
+                vFound.push_back(ret);
+                return ret;
+            }
 
-            // loop looking for next shortest path
-            while (true)
+            if (!vFound.size())
+                return ret;
+
+            // only the newest path can produce spur paths that have not already been found
+            spur();
+
+            // no more paths check
+            if (myCandidates.empty())
+                return ret;
+
+            // return cheapest candidate path
+            ret = std::make_pair(
+                myCandidates.top().second,
+                myCandidates.top().first.first);
+            myCandidates.pop();
+            vFound.push_back(ret);
+            return ret;
+        }
+
+        void cKShortestPaths::spur()
+        {
+            const path_t prev = vFound.back().first;
+
+            double rootCost = 0;
+            for (int i = 0; i < (int)prev.size() - 1; i++)
             {
-                // initialize
-                vPotentialPaths.clear();
-                auto gdwork = gd;
+                int spur = prev[i];
 
-                // loop over previously found shortest paths
-                for (auto &foundPath : vShortestPaths)
+                // links from the spur node used by found paths sharing this root
+                std::vector<int> vBlockedNext;
+                for (auto &found : vFound)
                 {
-                    // loop over the previously found path
-                    for (int rootlength = 1; rootlength < foundPath.first.size(); rootlength++)
-                    {
-                        // remove link from spur node used by previous path
-                        gdwork.g.remove(
-                            foundPath.first[rootlength - 1],
-                            foundPath.first[rootlength]);
-
-                        // find shortest path to destination ( spur path )
-                        // without using the link
-                        // dijsktra
-                        gdwork.startName = gd.g.userName(foundPath.first[rootlength - 1]);
-                        path_cost_t spurPath = path(gdwork);
-
-                        // check spur path found
-                        if (!spurPath.first.size())
-                            continue;
+                    if ((int)found.first.size() > i + 1 &&
+                        std::equal(
+                            prev.begin(), prev.begin() + i + 1,
+                            found.first.begin()))
+                        vBlockedNext.push_back(found.first[i + 1]);
+                }
 
-                        // combine root and spur paths
-                        combine_yen(
-                            spurPath,
-                            foundPath,
-                            rootlength,
-                            gd);
+                auto spurPath = spur_yen(myGD, spur, myEnd, vBlocked, vBlockedNext);
 
-                        // check this is new path
-                        if (isNewPath_yen(spurPath, vShortestPaths))
-                            vPotentialPaths.push_back(spurPath);
-                    }
+                if (spurPath.first.size())
+                {
+                    // combine root and spur paths
+                    path_t total(prev.begin(), prev.begin() + i);
+                    total.insert(total.end(), spurPath.first.begin(), spurPath.first.end());
+
+                    if (mySeen.insert(total).second)
+                        myCandidates.push(std::make_pair(
+                            std::make_pair(rootCost + spurPath.second, myCandidateCount++),
+                            total));
                 }
 
-                // no more paths check
-                if (!vPotentialPaths.size())
-                    break;
+                // extend the root path
+                vBlocked[spur] = true;
+                rootCost += myGD.edgeWeight[myGD.g.find(spur, prev[i + 1])];
+            }
 
-                // Add shortest potential path to output
-                vShortestPaths.push_back(
-                    *std::min_element(
-                        vPotentialPaths.begin(), vPotentialPaths.end(),
-                        [](path_cost_t &a, path_cost_t &b)
-                        {
-                            return a.second < b.second;
-                        }));
+            // clear the overlay mask
+            for (int v : prev)
+                vBlocked[v] = false;
+        }
+
+        vPath_t
+        kShortestPaths(sGraphData &gd, int K)
+        {
+            vPath_t vShortestPaths;
+            cKShortestPaths gen(gd);
+            while ((int)vShortestPaths.size() < K)
+            {
+                auto p = gen.next();
+                if (!p.first.size())
+                    break;
+                vShortestPaths.push_back(p);
             }
             return vShortestPaths;
         }
 
+        vPath_t
+        allPaths(sGraphData &gd)
+        {
+            return kShortestPaths(gd, INT_MAX);
+        }
+
         void cSpanningTree::add(
             const cGraph &g,
             int v, int w)
@@ -302,84 +474,51 @@ namespace raven
         {
             // std::cout << "spanning Tree " << startName << "\n";
 
-            if (gd.edgeWeight.size() < gd.g.edgeCount())
-                throw std::runtime_error(
-                    "spanningTree bad edge weights");
-
-            // copy vertices from input graph to spanning tree
-            cSpanningTree ST;
-            for (int kv = 0; kv < gd.g.vertexCount(); kv++)
-                ST.mySpanningTree.add(gd.g.userName(kv));
-
             int start = gd.g.find(gd.startName);
-
-            // track visited vertices
-            std::vector<bool> visited(gd.g.vertexCount(), false);
-
-            // add start vertex to spanning tree
-            int v = start;
-            auto va = gd.g.adjacentOut(v);
-            if (!va.size())
-                throw std::runtime_error(
-                    "spanning tree start vertex unconnected");
-            visited[v] = true;
-
-            // while nodes remain outside of span
-            while (gd.g.vertexCount() > ST.vertexCount())
+            cGraph tree = spanningTree(gd.g, gd.edgeWeight, start);
+            if (!tree.vertexCount())
             {
-                double min_cost = INT_MAX;
-                std::pair<int, int> bestLink;
-                bestLink.first = -1;
-
-                // loop over nodes in span
-                for (int v = 0; v < gd.g.vertexCount(); v++)
+                std::vector<bool> visited(gd.g.vertexCount(), false);
+                visited[start] = true;
+                for (int ei : spanningTreePrim(gd.g, gd.edgeWeight, start))
                 {
-                    if (!visited[v])
-                        continue;
-
-                    // loop over adjacent nodes not in span
-                    for (auto w : gd.g.adjacentOut(v))
-                    {
-                        // std::cout << "try " << g.userName(v) <<" "<< g.userName(w) << "\n";
-                        if (visited[w])
-                            continue;
-
-                        // check edge exists
-                        int ei = gd.g.find(v, w);
-                        if (ei < 0)
-                            continue;
-
-                        // track cheapest edge
-                        double cost = gd.edgeWeight[ei];
-                        if (cost < min_cost)
-                        {
-                            min_cost = cost;
-                            bestLink = std::make_pair(v, w);
-                        }
-                    }
-                }
-
-                if (bestLink.first == -1)
-                {
-                    std::cout << "spanning tree starting from " << gd.startName << " cannot reach ";
-                    for (int v = 0; v < visited.size(); v++)
-                        if (!visited[v])
-                            std::cout << gd.g.userName(v) << " ";
-                    std::cout << "\n";
-                    // std::cout << g.text() << "\nPartial ST\n";
-                    // std::cout << ST.mySpanningTree.text();
-                    ST.mySpanningTree.clear();
-                    return ST.mySpanningTree;
+                    visited[gd.g.src(ei)] = true;
+                    visited[gd.g.dest(ei)] = true;
                 }
+                std::cout << "spanning tree starting from " << gd.startName << " cannot reach ";
+                for (int v = 0; v < visited.size(); v++)
+                    if (!visited[v])
+                        std::cout << gd.g.userName(v) << " ";
+                std::cout << "\n";
+            }
+            return tree;
+        }
 
-                // add cheapest link between node in tree to node not yet in tree
-                ST.add(gd.g, bestLink.first, bestLink.second);
+        cGraph
+        spanningTree(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start)
+        {
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "spanningTree bad edge weights");
 
-                visited[bestLink.first] = true;
-                visited[bestLink.second] = true;
-            }
+            if (start < 0 || !g.adjacentOutRef(start).size())
+                throw std::runtime_error(
+                    "spanning tree start vertex unconnected");
 
-            return ST.mySpanningTree;
+            auto edges = spanningTreePrim(g, edgeWeight, start);
+            if (edges.size() < g.vertexCount() - 1)
+                return cGraph();
+
+            // tree links are undirected, whatever the input graph
+            cGraph tree(g);
+            tree.removeLinks();
+            tree.directed(false);
+            for (int ei : edges)
+                tree.add(g.src(ei), g.dest(ei));
+            return tree;
         }
 
         void dfs(
@@ -387,42 +526,7 @@ namespace raven
             int startIndex,
             std::function<bool(int v)> visitor)
         {
-            // track visited vertices
-            std::vector<bool> visited(g.vertexCount(), false);
-
-            // vertices waiting to be visited
-            std::stack<int> wait;
-
-            /*  1 Start by putting one of the graph's vertices on top of a stack.
-                2 Take the top vertex off the stack and add it to the visited list.
-                3 Add adjacent vertices which aren't in the visited list to the top of the stack.
-                4 Keep repeating steps 2 and 3 until the stack is empty.
-            */
-
-            wait.push(startIndex);
-
-            while (!wait.empty())
-            {
-                int v = wait.top();
-                if (v < 0)
-                    throw std::runtime_error(
-                        "dfs bad index 1");
-                wait.pop();
-                if (visited[v])
-                    continue;
-                if (!visitor(v))
-                    break;
-                visited[v] = true;
-
-                for (int w : g.adjacentOut(v))
-                {
-                    if (w < 0)
-                        throw std::runtime_error(
-                            "dfs bad index 2");
-                    if (!visited[w])
-                        wait.push(w);
-                }
-            }
+            dfs<std::function<bool(int v)> &>(g, startIndex, visitor);
         }
 
         void bfs(
@@ -430,234 +534,30 @@ namespace raven
             int startIndex,
             std::function<bool(int v)> visitor)
         {
-
-            // queue of visited vertices with unsearched children
-            std::queue<int> Q;
-
-            // track nodes that have been visited
-            // prevent getting caught going around and around a cycle
-            std::vector<bool> visited(g.vertexCount(), false);
-
-            // start at start
-            Q.push(startIndex);
-            visited[startIndex] = true;
-            if (!visitor(startIndex))
-                return;
-
-            // loop while the queue is not empty
-            while (!Q.empty())
-            {
-                // get current vertex from front of queue
-                int v = Q.front();
-                Q.pop();
-
-                // loop over vertices reachable from current vertex
-                for (int u : g.adjacentOut(v))
-                {
-                    if (!visited[u])
-                    {
-                        // add to queue and mark visited
-                        Q.push(u);
-                        visited[u] = true;
-
-                        if (!visitor(v))
-                            return;
-                    }
-                }
-            }
+            bfs<std::function<bool(int v)> &>(g, startIndex, visitor);
         }
 
-        std::vector<std::vector<int>>
-        dfs_cycle_finder(sGraphData &gd)
+        std::vector<int>
+        bfsPath(sGraphData &gd)
         {
-            //            std::cout << gd.g.text() << "\n";
-
-            // store for found cycles, vertex indices in order reached.
-            std::vector<std::vector<int>> ret;
-
-            // store found cycle signatures
-            std::vector<std::vector<int>> vfoundCycleSignature;
-
-            // track visited vertices
-            std::vector<bool> visited(gd.g.vertexCount(), false);
-
-            /* cycles exist whatever the edge weights
-            So construct default edge weights for all edges
-            allowing for all possible edges
-            */
-            gd.edgeWeight.clear();
-            gd.edgeWeight.resize(
-                2 * gd.g.vertexCount() * gd.g.vertexCount(),
-                1);
-
-            // working graph data
-            // used to find cycle when previously visited vertex encountered
-            sGraphData work;
-            work.g = gd.g;
-            work.edgeWeight = gd.edgeWeight;
-
-            /* loop until all vertices have been visited
-
-            This is required for graphs that are not fully connected
-            i.e. not every vertex can be reached from every other
-
-            */
-            while (true)
-            {
-                int startIndex;
-                if (gd.startName.empty())
-                {
-                    // find unvisited vertex to start the DFS from
-                    auto it = std::find(
-                        visited.begin(),
-                        visited.end(),
-                        false);
-                    if (it == visited.end())
-                    {
-                        // all vertices have been visited - done
-                        break;
-                    }
-                    startIndex = it - visited.begin();
-                }
-                else
-                {
-                    startIndex = gd.g.find(gd.startName);
-                }
-
-                // vertices waiting to be processed
-                std::stack<int> wait;
-
-                // start from an unvisited vertex
-                wait.push(startIndex);
-
-                // continue until no more vertices can be reached from the starting vertex
-                while (!wait.empty())
-                {
-                    // visit vertex at top of stack
-                    int v = wait.top();
-                    wait.pop();
-                    visited[v] = true;
-                    // std::cout << "visit " << gd.g.userName(v) << " ";
-
-                    // loop over vertices reachable with one hop
-                    for (int w : gd.g.adjacentOut(v))
-                    {
-                        if (!visited[w])
-                        {
-                            // push unvisited vertex onto stack to be visited later
-                            wait.push(w);
-                            continue;
-                        }
-
-                        /* previously visited node
-
-                        before carrying on we need to if this is a novel cycle
-                        apply Dijsktra algorithm to find shortest path
-                        from w back to the common ancestor and then around to v again
-
-                        */
-                        // std::cout << "cycle finder "<< gd.g.userName(w) <<" "<< gd.g.userName(v) << ": ";
-                        std::vector<int> cycle;
-                        if (!gd.g.isDirected())
-                        {
-                            // for undirected  graphs
-                            // remove reverse edge
-                            // so the path is forced to go the long way around back to start
-
-                            work.startName = gd.g.userName(w);
-                            work.endName = gd.g.userName(v);
-                            work.g.remove(w, v);
-                            cycle = path(work).first;
-
-                            // restore removed edge
-                            work.g = gd.g;
-                        }
-                        else
-                        {
-                            work.startName = gd.g.userName(w);
-                            work.endName = gd.g.userName(v);
-                            cycle = path(work).first;
-                        }
-
-                        // for( int v : cycle )
-                        //     std::cout << gd.g.userName(v) << " ";
-                        // std::cout << "\n";
-
-                        // ignore "cycles" that just go back and forth over one edge
-                        if (cycle.size() < 2)
-                            continue;
-
-                        // create cycle signature
-                        // this is a list of the vertex indices in the cycle sorted in numerical order
-                        // i.e. the signature is the same no matter where the start begins
-                        std::vector<int> signature = cycle;
-                        std::sort(signature.begin(), signature.end());
-
-                        // check this is a new cycle
-                        // loop over previously found cycles
-                        bool fnew = true;
-                        for (auto &foundSignature : vfoundCycleSignature)
-                        {
-                            // check cycle length
-                            if (foundSignature.size() != signature.size())
-                                continue;
-
-                            // check cycle signature
-                            if (std::equal(
-                                    foundSignature.begin(),
-                                    foundSignature.end(),
-                                    signature.begin()))
-                            {
-                                // this cycle was found previously
-                                fnew = false;
-                                break;
-                            }
-                        }
-                        if (!fnew)
-                            continue;
-
-                        // this is a novel cycle
-
-                        // close the cycle
-                        cycle.push_back(w);
-
-                        // store in list of cycles found
-                        ret.push_back(cycle);
-
-                        // store the signature to prevent duplicates being stored
-                        vfoundCycleSignature.push_back(signature);
-                    }
-                }
-                if (!gd.startName.empty())
-                {
-                    std::vector<std::vector<int>> cycles_with_start;
-                    for (auto &c : ret)
-                    {
-                        if (std::find(c.begin(), c.end(), startIndex) != c.end())
-                            cycles_with_start.push_back(c);
-                    }
-                    ret = cycles_with_start;
-                    break;
-                }
-            }
-            return ret;
+            cSearchWorkspace work;
+            return bfsPath(gd, work);
         }
 
         std::vector<int>
-        bfsPath(sGraphData &gd)
+        bfsPath(sGraphData &gd, cSearchWorkspace &work)
         {
             // the path will be stored here
             std::vector<int> path;
 
-            // queue of visited vertices with unsearched children
-            std::queue<int> Q;
-
             // track nodes that have been visited
             // prevent getting caught going around and around a cycle
-            std::vector<bool> visited(gd.g.vertexCount(), false);
+            // and store the vertex which every visited vertex was reached from
+            work.start(gd.g.vertexCount());
 
-            // store the vertex which every visited vertex was reached from
-            std::vector<int> pred(gd.g.vertexCount(), -1);
+            // queue of visited vertices with unsearched children
+            auto &Q = work.waiting();
+            int front = 0;
 
             if (!gd.edgeWeight.size())
                 gd.edgeWeight.resize(gd.g.edgeCount(), 1);
@@ -671,18 +571,17 @@ namespace raven
 
             // start at start
             int v = start;
-            Q.push(v);
-            visited[v] = true;
+            Q.push_back(v);
+            work.visit(v);
 
             // loop while the queue is not empty
-            while (!Q.empty())
+            while (front < Q.size())
             {
                 // get current vertex from front of queue
-                v = Q.front();
-                Q.pop();
+                v = Q[front++];
 
                 // loop over vertices reachable from current vertex
-                for (int u : gd.g.adjacentOut(v))
+                for (int u : gd.g.adjacentOutRef(v))
                 {
                     if (gd.edgeWeight[gd.g.find(v, u)] == 0)
                         continue;
@@ -690,26 +589,25 @@ namespace raven
                     if (u == dest)
                     {
                         // reached the destination, no need to search further
-                        pred[u] = v;
-                        std::queue<int> empty;
-                        std::swap(Q, empty);
+                        work.pred(u, v);
+                        front = Q.size();
                         break;
                     }
-                    if (!visited[u])
+                    if (!work.isVisited(u))
                     {
                         // visit to a new node
                         // because this is BFS, the first visit will be from
                         // the previous node on the shortest path
 
                         // add to queue, record predessor vertex, and mark visited
-                        Q.push(u);
-                        pred[u] = v;
-                        visited[u] = true;
+                        Q.push_back(u);
+                        work.pred(u, v);
+                        work.visit(u);
                     }
                 }
             }
 
-            if (pred[dest] == -1)
+            if (work.pred(dest) == -1)
             {
                 // destination not reachable
                 return path;
@@ -722,7 +620,7 @@ namespace raven
                 path.push_back(v);
                 if (v == start)
                     break;
-                v = pred[v];
+                v = work.pred(v);
             }
 
             // flip path to start -> destination
@@ -815,50 +713,62 @@ namespace raven
 
         std::vector<path_t> components(
             const cGraph &g)
+        {
+            cSearchWorkspace work;
+            return components(g, work);
+        }
+
+        std::vector<path_t> components(
+            const cGraph &g,
+            cSearchWorkspace &work)
         {
             std::vector<path_t> ret;
 
+            // in a directed graph reaching a vertex does not mean it can reach back
+            if (g.isDirected())
+                return componentGroups(strongComponents(g));
+
             // track visited vertices
-            std::vector<bool> visited(g.vertexCount(), false);
+            work.start(g.vertexCount());
+
+            // reachable vertices waiting to be visited
+            auto &wait = work.waiting();
 
             for (int startIndex = 0; startIndex < g.vertexCount(); startIndex++)
             {
-                if (visited[startIndex])
+                if (work.isVisited(startIndex))
                     continue;
 
                 std::vector<int> component;
 
-                // reachable vertices waiting to be visited
-                std::stack<int> wait;
-
                 /*  1 Start by putting one of the graph's vertices on top of a stack.
                     2 Take the top vertex off the stack and add it to the visited list.
                     3 Add adjacent vertices which aren't in the visited list to the top of the stack.
                     4 Keep repeating steps 2 and 3 until the stack is empty.
                 */
 
-                wait.push(startIndex);
+                wait.push_back(startIndex);
 
                 while (!wait.empty())
                 {
-                    int v = wait.top();
+                    int v = wait.back();
                     if (v < 0)
                         throw std::runtime_error(
                             "dfs bad index 1");
-                    wait.pop();
-                    if (visited[v])
+                    wait.pop_back();
+                    if (work.isVisited(v))
                         continue;
 
-                    visited[v] = true;
+                    work.visit(v);
                     component.push_back(v);
 
-                    for (int w : g.adjacentOut(v))
+                    for (int w : g.adjacentOutRef(v))
                     {
                         if (w < 0)
                             throw std::runtime_error(
                                 "dfs bad index 2");
-                        if (!visited[w])
-                            wait.push(w);
+                        if (!work.isVisited(w))
+                            wait.push_back(w);
                     }
                 }
                 // search has reached every reachable vertex from startIndex
@@ -901,7 +811,11 @@ namespace raven
 
                 */
 
-                auto p = bfsPath(residual);
+                auto p = bfsPath(
+                    residual,
+                    residual.g.vertexCount() < 100000
+                        ? bfs_engine::topdown
+                        : bfs_engine::parallel);
 
                 if (!p.size())
                     break;
@@ -1007,28 +921,37 @@ namespace raven
             std::vector<int> vsink;
             for (int vi = 0; vi < g.vertexCount(); vi++)
             {
-                if (!g.adjacentOut(vi).size())
+                if (!g.adjacentOutRef(vi).size())
                     vsink.push_back(vi);
             }
 
+            // search the condensation, a vertex for each strongly connected component
+            auto label = strongComponents(g);
+            auto dag = condensation(g, label);
+            cSearchWorkspace work;
+
             // loop over vertices
             for (int vi = 0; vi < g.vertexCount(); vi++)
             {
                 // check for source
-                if (g.adjacentIn(vi).size())
+                if (g.adjacentInRef(vi).size())
                     continue;
 
-                // find path to every other vertex
-                std::vector<double> dist;
-                std::vector<int> pred;
-                dijsktra(g, edgeWeight, vi, dist, pred);
+                // mark components reachable from source
+                dfs(
+                    dag, label[vi],
+                    [](int c)
+                    {
+                        return true;
+                    },
+                    work);
 
                 // find connected sinks
                 std::vector<int> vConnected;
                 vConnected.push_back(vi);
                 for (int si : vsink)
                 {
-                    if (pred[si] >= 0)
+                    if (work.isVisited(label[si]))
                         vConnected.push_back(si);
                 }
                 ret.push_back(vConnected);
@@ -1061,8 +984,10 @@ namespace raven
                     continue;
 
                 // iterate over all paths from starting node to target node
+                // generating each path only when it is needed
                 gd.startName = gd.g.userName(vi);
-                for (auto &path : allPaths(gd))
+                cKShortestPaths gen(gd);
+                for (auto path = gen.next(); path.first.size(); path = gen.next())
                 {
                     // loop over nodes in path
                     for (int n : path.first)
@@ -1308,182 +1233,5 @@ namespace raven
                 return 0;
             return closedCount / sumki;
         }
-
-        cTSP::cTSP(raven::graph::cGraph &inputGraph,
-                   const std::vector<double> &vEdgeWeight)
-            : g(inputGraph),
-              myEdgeWeight(vEdgeWeight),
-              final_res(INT_MAX)
-        {
-        }
-
-        // This function sets up final_path[]
-        std::vector<int> cTSP::calculate()
-        {
-
-            // Calculate initial lower bound for the root node
-            // using the formula 1/2 * (sum of first min +
-            // second min) for all edges.
-            // Also initialize the curr_path and visited array
-            int curr_bound = 0;
-
-            curr_path.clear();
-            curr_path.resize(g.vertexCount() + 1, -1);
-            visited.clear();
-            visited.resize(g.vertexCount(), false);
-
-            // Compute initial bound
-            // auto g = makeGraph( adj );
-            for (int i = 0; i < g.vertexCount(); i++)
-                curr_bound += (firstMin(i) +
-                               secondMin(i));
-
-            // Rounding off the lower bound to an integer
-            curr_bound = (curr_bound & 1) ? curr_bound / 2 + 1 : curr_bound / 2;
-
-            // We start at vertex 1 so the first vertex
-            // in curr_path[] is 0
-            visited[0] = true;
-            curr_path[0] = 0;
-
-            // Call to TSPRec for curr_weight equal to
-            // 0 and level 1
-            TSPRec(curr_bound, 0, 1);
-
-            return final_path;
-        }
-        // Function to find the minimum edge cost
-        // having an end at the vertex i
-        int cTSP::firstMin(int i)
-        {
-            int min = INT_MAX;
-            for (int k : g.adjacentOut(i))
-            {
-                if (k != i)
-                {
-                    int c = edgeWeight(i, k);
-                    if (c < min)
-                        min = c;
-                }
-            }
-            return min;
-        }
-
-        // function to find the second minimum edge cost
-        // having an end at the vertex i
-        int cTSP::secondMin(int i)
-        {
-            int first = INT_MAX, second = INT_MAX;
-            for (int j = 0; j < g.vertexCount(); j++)
-            {
-                if (i == j)
-                    continue;
-
-                int c = edgeWeight(i, j);
-                if (c <= first)
-                {
-                    second = first;
-                    first = c;
-                }
-                else if (c <= second &&
-                         c != first)
-                    second = c;
-            }
-            return second;
-        }
-
-        // recursive function that takes as arguments:
-        // curr_bound -> lower bound of the root node
-        // curr_weight-> stores the weight of the path so far
-        // level-> current level while moving in the search
-        //		 space tree
-
-        void cTSP::TSPRec(int curr_bound, int curr_weight,
-                          int level)
-        {
-            // base case is when we have reached level N which
-            // means we have covered all the nodes once
-            if (level == g.vertexCount())
-            {
-                // check if there is an edge from last vertex in
-                // path back to the first vertex
-                if (g.find(curr_path[level - 1], curr_path[0]) >= 0)
-                {
-                    // curr_res has the total weight of the
-                    // solution we got
-                    int curr_res = curr_weight +
-                                   edgeWeight(curr_path[level - 1], curr_path[0]);
-
-                    // Update final result and final path if
-                    // current result is better.
-                    if (curr_res < final_res)
-                    {
-                        final_path.clear();
-                        for (int v : curr_path)
-                            if (v >= 0)
-                                final_path.push_back(v);
-                        final_path.push_back(curr_path[0]);
-                        final_res = curr_res;
-                    }
-                }
-                return;
-            }
-
-            // for any other level iterate for all vertices to
-            // build the search space tree recursively
-            for (int i = 0; i < g.vertexCount(); i++)
-            {
-                // Consider next vertex if it is not same (diagonal
-                // entry in adjacency matrix and not visited
-                // already)
-                if (g.find(curr_path[level - 1], i) >= 0 &&
-                    visited[i] == false)
-                {
-                    int temp = curr_bound;
-                    curr_weight += edgeWeight(curr_path[level - 1], i);
-
-                    // different computation of curr_bound for
-                    // level 2 from the other levels
-                    if (level == 1)
-                        curr_bound -= ((firstMin(curr_path[level - 1]) +
-                                        firstMin(i)) /
-                                       2);
-                    else
-                        curr_bound -= ((secondMin(curr_path[level - 1]) +
-                                        firstMin(i)) /
-                                       2);
-
-                    // curr_bound + curr_weight is the actual lower bound
-                    // for the node that we have arrived on
-                    // If current lower bound < final_res, we need to explore
-                    // the node further
-                    if (curr_bound + curr_weight < final_res)
-                    {
-                        curr_path[level] = i;
-                        visited[i] = true;
-
-                        // call TSPRec for the next level
-                        TSPRec(curr_bound, curr_weight, level + 1);
-                    }
-
-                    // Else we have to prune the node by resetting
-                    // all changes to curr_weight and curr_bound
-                    curr_weight -= edgeWeight(curr_path[level - 1], i);
-                    curr_bound = temp;
-
-                    // Also reset the visited array
-                    visited.clear();
-                    visited.resize(g.vertexCount(), false);
-
-                    for (int j = 0; j <= level - 1; j++)
-                        visited[curr_path[j]] = true;
-                }
-            }
-        }
-
-        int cTSP::edgeWeight(int i, int j) const
-        {
-            return myEdgeWeight[g.find(i, j)];
-        }
     }
 }
@@ -1,6 +1,13 @@
 #pragma once
+#include <climits>
+#include <cmath>
 #include <set>
+#include <stack>
+#include <queue>
+#include <unordered_set>
 #include <functional>
+#include <istream>
+#include <stdexcept>
 #include "cGraph.h"
 
 namespace raven
@@ -64,13 +71,206 @@ namespace raven
         typedef std::pair<path_t, double> path_cost_t;
         typedef std::vector<path_cost_t> vPath_t;
 
+        /// @brief Working storage for searches, reused from one search to the next
+        ///
+        /// Starting a new search is O(1), rather than allocating and clearing arrays for every vertex.
+        /// Each entry is stamped with the generation of the search that wrote it,
+        /// entries with an older stamp read as not visited, no predecessor, infinite distance.
+        ///
+        /// A workspace can only be used by one search at a time, so use one per thread
+        /// and do not start another search with it from inside a visitor.
+
+        class cSearchWorkspace
+        {
+        public:
+            cSearchWorkspace()
+                : myGeneration(0)
+            {
+            }
+
+            /// @brief start a new search
+            /// @param vertexCount number of vertices in the graph to be searched
+            void start(int vertexCount);
+
+            bool isVisited(int v) const
+            {
+                return myVisited[v] == myGeneration;
+            }
+            void visit(int v)
+            {
+                myVisited[v] = myGeneration;
+            }
+
+            /// @brief previous vertex on path to vertex, -1 if none
+            int pred(int v) const
+            {
+                if (myPredStamp[v] != myGeneration)
+                    return -1;
+                return myPred[v];
+            }
+            void pred(int v, int p)
+            {
+                myPredStamp[v] = myGeneration;
+                myPred[v] = p;
+            }
+
+            /// @brief distance to vertex, INT_MAX if not set
+            double dist(int v) const
+            {
+                if (myDistStamp[v] != myGeneration)
+                    return INT_MAX;
+                return myDist[v];
+            }
+            void dist(int v, double d)
+            {
+                myDistStamp[v] = myGeneration;
+                myDist[v] = d;
+            }
+
+            /// @brief vertices waiting to be searched, emptied by start()
+            std::vector<int> &waiting()
+            {
+                return myWait;
+            }
+
+        private:
+            unsigned myGeneration;
+            std::vector<unsigned> myVisited;
+            std::vector<unsigned> myPredStamp;
+            std::vector<unsigned> myDistStamp;
+            std::vector<int> myPred;
+            std::vector<double> myDist;
+            std::vector<int> myWait;
+        };
+
+        /// @brief hash a path's vertex sequence
+        struct sPathHash
+        {
+            size_t operator()(const path_t &p) const;
+        };
+
+        /// @brief Generate paths between two nodes, cheapest first, on demand
+        /// algorithm: Yen
+        ///
+        /// Usage:
+        /// <pre>
+        ///    cKShortestPaths gen(gd);
+        ///    for (auto p = gen.next(); p.first.size(); p = gen.next())
+        ///    {
+        ///        ... use p, break when no more paths are needed
+        ///    }
+        /// </pre>
+        ///
+        /// Each call to next() does the work of one Yen iteration,
+        /// so paths that are never requested are never calculated.
+        /// The graph links and link costs must not be changed while the generator is in use.
+
+        class cKShortestPaths
+        {
+        public:
+            /// @brief CTOR
+            /// @param gd graph data, with start and end names set
+            ///
+            /// Missing link costs are set to 1
+
+            cKShortestPaths(sGraphData &gd);
+
+            /// @brief next cheapest path
+            /// @return pair: vector of node indices on the path, path cost
+            /// @return pair: empty vector, -1 when there are no more paths
+
+            path_cost_t next();
+
+            /// @brief number of paths returned so far
+            int count() const
+            {
+                return vFound.size();
+            }
+
+        private:
+            sGraphData &myGD;
+            int myEnd;
+            bool myfStarted;
+
+            // paths returned so far
+            vPath_t vFound;
+
+            // candidate paths, cheapest on top
+            // ties are broken by the order in which the candidates were found
+            typedef std::pair<std::pair<double, int>, path_t> candidate_t;
+            std::priority_queue<
+                candidate_t,
+                std::vector<candidate_t>,
+                std::greater<candidate_t>>
+                myCandidates;
+            int myCandidateCount;
+
+            // every path that has been found or is a candidate
+            std::unordered_set<path_t, sPathHash> mySeen;
+
+            // root path vertices, masked out of the spur path search
+            std::vector<bool> vBlocked;
+
+            /// @brief add candidates spurring from the newest found path
+            void spur();
+        };
+
+        /// @brief Set of cycles, ignoring where each cycle starts
+        ///
+        /// A cycle is stored in canonical form, rotated to start at its lowest vertex index.
+        /// For undirected cycles the direction is also normalised, so the reverse cycle is the same cycle.
+        /// Insertion and lookup are O(L) in the cycle length.
+
+        class cCycleSet
+        {
+        public:
+            /// @brief CTOR
+            /// @param fDirected false if a cycle and its reverse are the same cycle
+            cCycleSet(bool fDirected = true)
+                : myfDirected(fDirected)
+            {
+            }
+
+            /// @brief add a cycle
+            /// @param cycle vertex indices, with or without the first vertex repeated at the end
+            /// @return true if the cycle was not already in the set
+            bool insert(const path_t &cycle);
+
+            /// @brief true if cycle is in the set
+            bool contains(const path_t &cycle) const;
+
+            /// @brief cycle in canonical form
+            /// @param cycle vertex indices, with or without the first vertex repeated at the end
+            /// @return cycle starting at lowest vertex index, without repeated vertex
+            path_t canonical(const path_t &cycle) const;
+
+            int size() const
+            {
+                return mySet.size();
+            }
+            void clear()
+            {
+                mySet.clear();
+            }
+
+        private:
+            bool myfDirected;
+            std::unordered_set<path_t, sPathHash> mySet;
+        };
+
         class cTourNodes
         {
         public:
             /// @brief Calculate the tour
             // @param gd graph data
             // gd.startName vertex to start tour from, empty to find optimum starting point
-            void calculate(sGraphData &gd);
+            // @param threads number of threads trying starting points, 0 for all cores
+            //
+            // The starting points are shared between the threads, each with its own copy of the search state.
+            // The result is the same as trying them one by one.
+            void calculate(
+                sGraphData &gd,
+                int threads = 0);
 
             std::vector<int> getTour() const
             {
@@ -92,18 +292,33 @@ namespace raven
         private:
             const cGraph *g;
             std::vector<double> myEdgeWeights;
-            cGraph spanTree;
+
+            // spanning tree
+            sGraphData mySpan;
 
             int dfsStart;
             int unvisited;
-            std::vector<int> vleaf;
+            std::vector<bool> isLeaf;
             std::vector<bool> spanVisited;
+            std::vector<bool> isRevisited;
             std::vector<int> revisited;
 
+            // reused by each search, so a search costs nothing for vertices it does not reach
+            cSearchWorkspace myWork;
+
             std::vector<int> tour;
 
             void tourNodesAdd(int v);
 
+            /// @brief tour from one spanning tree root
+            /// @param gd graph data
+            /// @param spanTreeRoot
+            /// @return false if the spanning tree from root does not reach every vertex
+
+            bool tourFrom(
+                sGraphData &gd,
+                int spanTreeRoot);
+
             bool visitor(int v);
 
             /// @brief find leaf to jump to from leaf
@@ -114,12 +329,10 @@ namespace raven
 
             int isLeafJump(int v);
 
-            /// @brief find path to unvisited vertex, including visited vertices
+            /// @brief find path to an unvisited vertex, including visited vertices
+            /// @param start vertex index to search from
             /// @return last node in path, -1 if no path
-            int PathToUnvisited();
-
-            std::vector<int> vectorgraphIndexFromSpanIndex(
-                const std::vector<int> &visp);
+            int PathToUnvisited(int start);
         };
 
         class cSpanningTree
@@ -138,14 +351,188 @@ namespace raven
             }
         };
 
+        /// @brief share a range of work between threads
+        /// @param count number of work items
+        /// @param threads number of threads, 0 for all cores
+        /// @param work function to do items from first to last-1, as thread number t
+        /// @param parallelItems fewer items than this are done by the calling thread alone
+
+        void share(
+            int count,
+            int threads,
+            std::function<void(int first, int last, int t)> work,
+            int parallelItems = 10000);
+
+        /// @brief Spatial index of points on a plane, for nearest neighbour and radius queries
+        ///
+        /// A k-d tree, held as a permutation of the point indices.
+        /// Each range of the permutation is split at its median, across the wider spread of its points.
+
+        class cSpatialIndex
+        {
+        public:
+            /// @brief index points
+            /// @param x point locations
+            /// @param y
+
+            cSpatialIndex(
+                const std::vector<double> &x,
+                const std::vector<double> &y);
+
+            /// @brief index the cities of a graph
+            /// @param g graph with vertex attributes x, y, as read from a sales city file
+
+            cSpatialIndex(const cGraph &g);
+
+            /// @brief nearest points to a point, not including itself
+            /// @param v point index
+            /// @param k number of points wanted
+            /// @return point indices, nearest first, ties to the lower index
+
+            std::vector<int> nearest(int v, int k) const;
+
+            /// @brief nearest points to a location
+            /// @param x location
+            /// @param y
+            /// @param k number of points wanted
+            /// @return point indices, nearest first, ties to the lower index
+
+            std::vector<int> nearest(double x, double y, int k) const;
+
+            /// @brief points near a location
+            /// @param x location
+            /// @param y
+            /// @param radius
+            /// @return indices of points no further than radius from the location, in increasing order
+
+            std::vector<int> within(double x, double y, double radius) const;
+
+            int count() const
+            {
+                return myX.size();
+            }
+            const std::vector<double> &x() const
+            {
+                return myX;
+            }
+            const std::vector<double> &y() const
+            {
+                return myY;
+            }
+
+        private:
+            // ranges this small are searched point by point
+            static const int leafSize = 8;
+
+            std::vector<double> myX;
+            std::vector<double> myY;
+
+            // point indices, in tree order
+            std::vector<int> myOrder;
+
+            // true if the range split at this position of myOrder is split across y
+            std::vector<bool> mySplitY;
+
+            void build();
+
+            std::vector<int> search(
+                double x, double y,
+                int k,
+                int exclude) const;
+        };
+
+        /// @brief Complete graph of points on a plane, every pair linked by a straight line
+        ///
+        /// Link costs are computed from the locations when needed, so no links are stored.
+
+        class cEuclideanGraph
+        {
+        public:
+            /// @brief points
+            /// @param x point locations
+            /// @param y
+
+            cEuclideanGraph(
+                const std::vector<double> &x,
+                const std::vector<double> &y);
+
+            /// @brief the cities of a graph
+            /// @param g graph with vertex attributes x, y, as read from a sales city file
+
+            cEuclideanGraph(const cGraph &g);
+
+            int vertexCount() const
+            {
+                return myX.size();
+            }
+
+            /// @brief cost of link between two vertices, the distance between them
+            double edgeWeight(int u, int v) const
+            {
+                double dx = myX[u] - myX[v];
+                double dy = myY[u] - myY[v];
+                return std::sqrt(dx * dx + dy * dy);
+            }
+
+            /// @brief costs of links from one vertex to every vertex
+            /// @param u vertex index
+            /// @param[out] weight resized to vertexCount, weight[v] is the cost of the link u to v
+            ///
+            /// One pass over the locations, which the compiler can vectorize
+
+            void edgeWeights(int u, std::vector<double> &weight) const;
+
+            const std::vector<double> &x() const
+            {
+                return myX;
+            }
+            const std::vector<double> &y() const
+            {
+                return myY;
+            }
+
+        private:
+            std::vector<double> myX;
+            std::vector<double> myY;
+        };
+
         /// @brief Travelling Salesman Problem using Branch and Bound.
+        ///
+        /// Distances are held in a flat matrix, the cheapest links of each vertex are found once
+        /// and the lower bound of a partial tour is updated as each vertex is added.
+        /// Subtrees of the search are shared between threads, which prune against the best tour any has found.
+        /// When tours tie, the first in vertex order wins, whatever the number of threads.
+
         class cTSP
         {
         public:
             cTSP(raven::graph::cGraph &inputGraph,
                  const std::vector<double> &vEdgeWeight);
 
-            std::vector<int> calculate();
+            /// @brief tour through cities on a plane, every pair linked by a straight line
+            /// @param cities
+
+            cTSP(const cEuclideanGraph &cities);
+
+            /// @brief find the cheapest tour visiting every vertex
+            /// @param threads number of threads, 0 for all cores
+            /// @param seconds time limit, 0 for none
+            /// @return vertex indices of tour, starting and ending at vertex 0, empty if none or out of time
+            ///
+            /// Run time grows steeply with the number of vertices,
+            /// 30 vertices can take tens of seconds on one core
+
+            std::vector<int> calculate(
+                int threads = 0,
+                double seconds = 0);
+
+            /// @brief find the cheapest tour visiting every vertex, by Held-Karp dynamic programming
+            /// @param threads number of threads, 0 for all cores
+            /// @return vertex indices of tour, starting and ending at vertex 0, empty if none
+            ///
+            /// Run time and memory depend only on the number of vertices, which must be 20 or less
+
+            std::vector<int> calculateHeldKarp(int threads = 0);
 
             int TotalPathEdgeWeight() const
             {
@@ -157,31 +544,23 @@ namespace raven
             // path of the salesman.
             std::vector<int> final_path;
 
-            std::vector<int> curr_path;
-
-            // visited[] keeps track of the already visited nodes
-            // in a particular path
-            std::vector<bool> visited;
-
             // Stores the final minimum weight of shortest tour.
             int final_res;
 
-            raven::graph::cGraph &g;
-            const std::vector<double> &myEdgeWeight;
+            int myN;
+            bool myDirected;
 
-            void TSPRec(int curr_bound,
-                        int curr_weight,
-                        int level);
-
-            int firstMin(int i);
-            int secondMin(int i);
-
-            int edgeWeight(int i, int j) const;
+            // flat distance matrix, infinite where there is no link
+            std::vector<double> myDist;
         };
 
-        /// @brief Find articulation points in an undirected graph
+        /// @brief Find articulation points, bridges and biconnected components in an undirected graph
         /// An articulation point is a vertex whose removal
         /// increases the number of connected components in the graph.
+        /// A bridge is a link whose removal increases the number of connected components.
+        /// A biconnected component is a maximal set of links where any two share a cycle.
+        ///
+        /// The depth first search uses an explicit stack, so long paths do not overflow the call stack.
 
         class cTarjan
         {
@@ -192,24 +571,63 @@ namespace raven
 
             std::vector<std::string> ArticulationPoints(sGraphData &gd);
 
+            /// @brief Search for articulation points, bridges and biconnected components
+            /// @param g undirected graph ( directed will raise exception )
+            ///
+            /// Results are available from the accessors until the next search
+
+            void search(const cGraph &g);
+
+            /// @brief articulation point vertex indices, in increasing order
+            const std::vector<int> &articulationPoints() const
+            {
+                return vAP;
+            }
+
+            /// @brief bridges, vertex index pairs with the vertex nearer the search root first
+            const std::vector<std::pair<int, int>> &bridges() const
+            {
+                return vBridge;
+            }
+
+            /// @brief vertex indices in each biconnected component, in increasing order
+            ///
+            /// An articulation point is in every component it joins, an isolated vertex is in none
+
+            const std::vector<std::vector<int>> &biconnectedComponents() const
+            {
+                return vBiconnected;
+            }
+
         private:
-            std::vector<bool> visited; // true if vertex index has been visited
-            std::vector<int> disc;     // discovery times of visited vertices
+            std::vector<int> disc;     // discovery times of visited vertices, 0 if not visited
             std::vector<int> low;      // earliest visited vertex (the vertex with minimum
                                        // discovery time) that can be reached from subtree
                                        // rooted with vertex
-            std::set<int> sAP;         // set of articulation point vertex indices
-
-            /// @brief Recursive search graph for articulation points
-            /// @param gd graph description
-            /// @param time current time
-            /// @param parent vertex index to start search from
-
-            void APRecurse(
-                sGraphData &gd,
-                int &time, int parent);
+            std::vector<int> vAP;      // articulation point vertex indices
+            std::vector<std::pair<int, int>> vBridge;
+            std::vector<std::vector<int>> vBiconnected;
         };
 
+        /// @brief Find articulation points and bridges in an undirected graph, using several threads
+        /// @param g undirected graph ( directed will raise exception )
+        /// @param[out] articulationPoints vertex indices, in increasing order
+        /// @param[out] bridges vertex index pairs with the vertex nearer the spanning tree root first
+        /// @param threads number of threads, 0 for all cores
+        ///
+        /// algorithm: Tarjan-Vishkin.
+        /// A breadth first spanning forest is numbered in preorder,
+        /// the lowest and highest preorder reached by a non tree link from each subtree are found level by level,
+        /// and tree links are joined into biconnected components by a concurrent union find on an auxiliary graph.
+        /// The per vertex and per link steps are shared between the threads, small graphs run on the calling thread.
+        /// The results are the same as cTarjan's, except for the order of the vertices in each bridge.
+
+        void cutsParallel(
+            const cGraph &g,
+            std::vector<int> &articulationPoints,
+            std::vector<std::pair<int, int>> &bridges,
+            int threads = 0);
+
         /// @brief read input file
         /// @param[in/out] graphData to store input
 
@@ -228,6 +646,25 @@ namespace raven
             std::vector<double> &dist,
             std::vector<int> &pred);
 
+        /// @brief find shortest paths from start node, using a workspace
+        /// @param g
+        /// @param edgeWeight
+        /// @param start vertex index
+        /// @param end vertex index to stop at, -1 to find path to every node
+        /// @param[out] work shortest distance and previous node for each node reached, visited when path is final
+        ///
+        /// Only the vertices the search reaches are touched,
+        /// so many local searches on a large graph are cheap.
+        /// work.pred( start ) is -1.
+        /// algorithm: Dijsktra with a binary heap
+
+        void dijsktra(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int end,
+            cSearchWorkspace &work);
+
         /// @brief find shortest path from start to end node
         /// @param gd  graph data
         /// @return pair: vector of node indices on the path, path cost
@@ -255,6 +692,15 @@ namespace raven
         vPath_t
         allPaths(sGraphData &gd);
 
+        /// @brief find the K cheapest paths between two nodes
+        /// @param gd  graph data
+        /// @param K maximum number of paths to find
+        /// @return vector of path, cost pairs in increasing cost order
+        /// algorithm: Yen, see cKShortestPaths
+
+        vPath_t
+        kShortestPaths(sGraphData &gd, int K);
+
         /// @brief find spanning tree
         /// @param gd  graph data
         /// @return graph - a tree rooted at start and visiting every node
@@ -262,6 +708,130 @@ namespace raven
         cGraph
         spanningTree(sGraphData &gd);
 
+        /// @brief find spanning tree, without reporting unreached vertices
+        /// @param g
+        /// @param edgeWeight
+        /// @param start vertex index
+        /// @return graph - a tree rooted at start and visiting every node, empty if start cannot reach every node
+        ///
+        /// Safe to call from several threads at once
+
+        cGraph
+        spanningTree(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start);
+
+        /// @brief minimum spanning tree, heap based
+        /// @param g
+        /// @param edgeWeight
+        /// @param start vertex index
+        /// @return edge indices of tree links, in the order they were added
+        ///
+        /// The tree spans the vertices reachable from start by out links.
+        /// Ties are broken as spanningTree() does, so the same tree is found.
+        /// algorithm: Prim, O(E log E)
+
+        std::vector<int> spanningTreePrim(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start);
+
+        /// @brief minimum spanning tree of points on a plane, every pair linked by a straight line
+        /// @param g
+        /// @param start vertex index
+        /// @return tree links, vertex index pairs with the vertex nearer start first, in the order they were added
+        ///
+        /// Ties go to the lowest vertex index.
+        /// algorithm: Prim, dense, O(V^2) time and O(V) memory
+
+        std::vector<std::pair<int, int>> spanningTreePrim(
+            const cEuclideanGraph &g,
+            int start = 0);
+
+        /// @brief minimum spanning forest
+        /// @param g
+        /// @param edgeWeight
+        /// @return edge indices of forest links, cheapest first
+        ///
+        /// Links are treated as undirected, there is a tree for every connected component.
+        /// algorithm: Kruskal, sort and union find, O(E log E)
+
+        std::vector<int> spanningTreeKruskal(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight);
+
+        /// @brief minimum spanning forest, using several threads
+        /// @param g
+        /// @param edgeWeight
+        /// @param threads number of threads, 0 for all cores
+        /// @return edge indices of forest links
+        ///
+        /// Links are treated as undirected, there is a tree for every connected component.
+        /// algorithm: Boruvka. In each round every component picks its cheapest outside link,
+        /// the links are shared between the threads which find the cheapest with atomic compare and swap.
+        /// Small rounds run on the calling thread.
+
+        std::vector<int> spanningForestBoruvka(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int threads = 0);
+
+        /// @brief graph from some links of another
+        /// @param g
+        /// @param edges edge indices in g
+        /// @return graph with all the vertices of g and only the links given
+
+        cGraph spanningGraph(
+            const cGraph &g,
+            const std::vector<int> &edges);
+
+        /// @brief shorten a tour by local search
+        /// @param g undirected graph
+        /// @param edgeWeight
+        /// @param tour vertex indices in visit order, revisits allowed
+        /// @param seconds time limit, 0 for none
+        /// @return pair: improved tour, tour cost
+        ///
+        /// The tour is open, it need not return to its start.
+        /// Moves: drop a revisit, 2-opt, and Or-opt moves of runs of up to 3 vertices,
+        /// tried against each vertex's 8 cheapest links, with don't look bits.
+        /// Every vertex in the tour is still visited.
+        /// Consecutive vertices that are not linked count as a jump costing more than any path.
+
+        path_cost_t tourOptimize(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            const path_t &tour,
+            double seconds = 1);
+
+        /// @brief find a short tour through many cities on a plane
+        /// @param x city locations
+        /// @param y
+        /// @param seconds time limit for improving the tour, 0 for no kicks and no time limit
+        /// @return pair: tour of city indices, starting and ending at city 0, tour length
+        ///
+        /// Cities are joined by straight lines, no graph links are needed.
+        /// The starting tour walks round a minimum spanning tree of the links to each city's 8 nearest neighbours.
+        /// 2-opt and Or-opt moves of runs of up to 3 cities, tried against the same neighbours
+        /// with don't look bits, then shorten it.
+        /// Double bridge kicks then continue until the time is up,
+        /// or until many kicks in a row have not shortened the tour.
+
+        path_cost_t tourCities(
+            const std::vector<double> &x,
+            const std::vector<double> &y,
+            double seconds = 10);
+
+        /// @brief find a short tour through many cities on a plane
+        /// @param cities spatial index of the city locations
+        /// @param seconds time limit for improving the tour, 0 for no kicks and no time limit
+        /// @return pair: tour of city indices, starting and ending at city 0, tour length
+
+        path_cost_t tourCities(
+            const cSpatialIndex &cities,
+            double seconds = 10);
+
         /// @brief depth first search
         /// @param g
         /// @param startIndex
@@ -284,20 +854,370 @@ namespace raven
             int startIndex,
             std::function<bool(int v)> visitor);
 
+        /// @brief depth first search, using a workspace
+        /// @param g
+        /// @param startIndex
+        /// @param visitor callable bool(int v), called when a new node is reached
+        /// @param work
+        /// visitor should return true, but false if the search should stop
+
+        template <class Visitor>
+        void dfs(
+            const cGraph &g,
+            int startIndex,
+            Visitor &&visitor,
+            cSearchWorkspace &work)
+        {
+            // track visited vertices
+            work.start(g.vertexCount());
+
+            // vertices waiting to be visited
+            auto &wait = work.waiting();
+
+            /*  1 Start by putting one of the graph's vertices on top of a stack.
+                2 Take the top vertex off the stack and add it to the visited list.
+                3 Add adjacent vertices which aren't in the visited list to the top of the stack.
+                4 Keep repeating steps 2 and 3 until the stack is empty.
+            */
+
+            wait.push_back(startIndex);
+
+            while (!wait.empty())
+            {
+                int v = wait.back();
+                if (v < 0)
+                    throw std::runtime_error(
+                        "dfs bad index 1");
+                wait.pop_back();
+                if (work.isVisited(v))
+                    continue;
+                if (!visitor(v))
+                    break;
+                work.visit(v);
+
+                for (int w : g.adjacentOutRef(v))
+                {
+                    if (w < 0)
+                        throw std::runtime_error(
+                            "dfs bad index 2");
+                    if (!work.isVisited(w))
+                        wait.push_back(w);
+                }
+            }
+        }
+
+        /// @brief depth first search, with a visitor that can be inlined
+        /// @param g
+        /// @param startIndex
+        /// @param visitor callable bool(int v), called when a new node is reached
+        /// visitor should return true, but false if the search should stop
+        ///
+        /// Lambdas and function objects resolve to this overload,
+        /// the std::function overload is a wrapper for it.
+
+        template <class Visitor>
+        void dfs(
+            const cGraph &g,
+            int startIndex,
+            Visitor &&visitor)
+        {
+            cSearchWorkspace work;
+            dfs(g, startIndex, visitor, work);
+        }
+
+        /// @brief breadth first search, with a visitor that can be inlined
+        /// @param g
+        /// @param startIndex
+        /// @param visitor callable bool(int v), called when a new node is reached
+        /// visitor should return true, but false if the search should stop
+        ///
+        /// Lambdas and function objects resolve to this overload,
+        /// the std::function overload is a wrapper for it.
+
+        template <class Visitor>
+        void bfs(
+            const cGraph &g,
+            int startIndex,
+            Visitor &&visitor)
+        {
+            cSearchWorkspace work;
+            bfs(g, startIndex, visitor, work);
+        }
+
+        /// @brief breadth first search, using a workspace
+        /// @param g
+        /// @param startIndex
+        /// @param visitor callable bool(int v), called when a new node is reached
+        /// @param work
+        /// visitor should return true, but false if the search should stop
+
+        template <class Visitor>
+        void bfs(
+            const cGraph &g,
+            int startIndex,
+            Visitor &&visitor,
+            cSearchWorkspace &work)
+        {
+            // queue of visited vertices with unsearched children
+            work.start(g.vertexCount());
+            auto &Q = work.waiting();
+            int front = 0;
+
+            // track nodes that have been visited
+            // prevent getting caught going around and around a cycle
+
+            // start at start
+            Q.push_back(startIndex);
+            work.visit(startIndex);
+            if (!visitor(startIndex))
+                return;
+
+            // loop while the queue is not empty
+            while (front < Q.size())
+            {
+                // get current vertex from front of queue
+                int v = Q[front++];
+
+                // loop over vertices reachable from current vertex
+                for (int u : g.adjacentOutRef(v))
+                {
+                    if (!work.isVisited(u))
+                    {
+                        // add to queue and mark visited
+                        Q.push_back(u);
+                        work.visit(u);
+
+                        if (!visitor(u))
+                            return;
+                    }
+                }
+            }
+        }
+
+        /// @brief traversal event handlers that do nothing
+        ///
+        /// Derive from this and hide the handlers that are needed.
+        /// dfsEvents and bfsEvents call the derived class handlers directly,
+        /// so there are no virtual or indirect calls.
+
+        struct sTraversalEvents
+        {
+            /// @brief vertex reached for the first time ( pre-order )
+            /// @return false to stop the search
+            bool discover(int v) { return true; }
+
+            /// @brief every link out of vertex has been followed ( post-order )
+            void finish(int v) {}
+
+            /// @brief link u -> v followed to reach v for the first time
+            void treeEdge(int u, int v) {}
+
+            /// @brief link u -> v to a vertex on the current search path ( dfs only )
+            void backEdge(int u, int v) {}
+
+            /// @brief link u -> v to a vertex reached previously, and not on the search path
+            void nonTreeEdge(int u, int v) {}
+        };
+
+        /// @brief depth first search, reporting traversal events
+        /// @param g
+        /// @param startIndex
+        /// @param events handlers, a class derived from sTraversalEvents
+        ///
+        /// Unlike dfs(), this follows links in adjacency order
+        /// and keeps the search path on an explicit stack,
+        /// so the finish ( post-order ) event is available.
+        /// For undirected graphs the link back to the parent is reported as a back edge.
+
+        template <class Events>
+        void dfsEvents(
+            const cGraph &g,
+            int startIndex,
+            Events &events)
+        {
+            // 0 not reached, 1 on search path, 2 finished
+            std::vector<char> state(g.vertexCount(), 0);
+
+            // search path: vertex and index of next link to follow
+            std::vector<std::pair<int, int>> path;
+
+            state[startIndex] = 1;
+            if (!events.discover(startIndex))
+                return;
+            path.push_back(std::make_pair(startIndex, 0));
+
+            while (!path.empty())
+            {
+                int u = path.back().first;
+                const auto &adj = g.adjacentOutRef(u);
+                if (path.back().second == adj.size())
+                {
+                    // backtrack
+                    state[u] = 2;
+                    events.finish(u);
+                    path.pop_back();
+                    continue;
+                }
+                int v = adj[path.back().second++];
+
+                switch (state[v])
+                {
+                case 0:
+                    events.treeEdge(u, v);
+                    state[v] = 1;
+                    if (!events.discover(v))
+                        return;
+                    path.push_back(std::make_pair(v, 0));
+                    break;
+                case 1:
+                    events.backEdge(u, v);
+                    break;
+                default:
+                    events.nonTreeEdge(u, v);
+                    break;
+                }
+            }
+        }
+
+        /// @brief breadth first search, reporting traversal events
+        /// @param g
+        /// @param startIndex
+        /// @param events handlers, a class derived from sTraversalEvents
+        ///
+        /// finish is called when every link out of a vertex has been followed.
+        /// Links to previously reached vertices are reported as non tree edges.
+
+        template <class Events>
+        void bfsEvents(
+            const cGraph &g,
+            int startIndex,
+            Events &events)
+        {
+            std::queue<int> Q;
+            std::vector<bool> visited(g.vertexCount(), false);
+
+            Q.push(startIndex);
+            visited[startIndex] = true;
+            if (!events.discover(startIndex))
+                return;
+
+            while (!Q.empty())
+            {
+                int u = Q.front();
+                Q.pop();
+
+                for (int v : g.adjacentOutRef(u))
+                {
+                    if (visited[v])
+                    {
+                        events.nonTreeEdge(u, v);
+                        continue;
+                    }
+                    events.treeEdge(u, v);
+                    visited[v] = true;
+                    if (!events.discover(v))
+                        return;
+                    Q.push(v);
+                }
+                events.finish(u);
+            }
+        }
+
         /// @brief cycle finder
-        /// @param gd  graph data
-        /// @return vector of cycles
+        /// @param gd  graph data, if startName is set only cycles through it are returned
+        /// @return vector of cycles, each closed by repeating its first vertex at the end
+        ///
+        /// Every elementary cycle is stored once, for large graphs prefer elementaryCycles with a visitor
 
         std::vector<std::vector<int>>
         dfs_cycle_finder(sGraphData &gd);
 
+        /// @brief enumerate elementary cycles, passing each to a visitor as it is found
+        /// @param g graph
+        /// @param visitor called with each cycle's vertex indices, first vertex not repeated at end.
+        /// visitor should return true, but false if the enumeration should stop
+        /// @param maxLength maximum number of vertices in a cycle, 0 for no limit
+        ///
+        /// Each cycle starts at its lowest vertex index.
+        /// For undirected graphs each cycle is reported once, in one direction,
+        /// and back and forth over one link is not a cycle.
+        /// algorithm: Johnson, on the strongly connected component of each vertex
+        /// https://www.cs.tufts.edu/comp/150GA/homeworks/hw1/Johnson%2075.PDF
+
+        void elementaryCycles(
+            const cGraph &g,
+            std::function<bool(const path_t &cycle)> visitor,
+            int maxLength = 0);
+
+        /// @brief fundamental cycle basis of an undirected graph
+        /// @param g undirected graph
+        /// @return closed cycles, one for each link not in a breadth first spanning tree
+        ///
+        /// Every cycle in the graph is a sum, modulo 2 over its links, of cycles in the basis.
+        /// O(V+E) to find the tree, plus the total length of the cycles
+
+        std::vector<path_t> cycleBasis(const cGraph &g);
+
+        /// @brief minimum weight cycle basis of an undirected graph
+        /// @param g undirected graph
+        /// @param edgeWeight link costs, empty for all links cost 1
+        /// @return closed cycles, cheapest first
+        ///
+        /// algorithm: Horton, candidates from shortest path trees, independence by GF(2) elimination over link bitsets
+
+        std::vector<path_t> minimumCycleBasis(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight);
+
+        /// @brief length of shortest cycle
+        /// @param g
+        /// @return number of links in the shortest cycle, 0 if there are no cycles
+        ///
+        /// For undirected graphs back and forth over one link is not a cycle.
+        /// Breadth first search from each vertex, stopping at the depth of the best cycle so far
+
+        int girth(const cGraph &g);
+
         /// @brief find all paths between 2 vertices
         /// @param gd  graph data
         /// @return vector of path vectors
+        ///
+        /// Every path is stored, for large graphs prefer dfs_allpaths with a visitor
 
         std::vector<std::vector<int>>
         dfs_allpaths(sGraphData &gd);
 
+        /// @brief visit every simple path between 2 vertices, without storing them
+        /// @param g graph
+        /// @param edgeWeight link costs, empty for all links to cost 1
+        /// @param start vertex index
+        /// @param end vertex index
+        /// @param visitor function to call when a path is found
+        /// @param maxLength maximum number of links in a path, 0 for no limit
+        /// @param maxCost maximum path cost, negative for no limit
+        /// @param threads number of threads to share the first level branches, 0 for all cores
+        ///
+        /// visitor is passed the vertex indices on the path and the path cost.
+        /// The path is a view of the search stack, valid only during the call, copy it to keep it.
+        /// visitor should return true, but false if the search should stop
+        ///
+        /// Partial paths that exceed the limits are pruned, link costs must not be negative.
+        ///
+        /// With more than one thread the visitor calls are serialized,
+        /// but the order in which the paths are found is not defined.
+        ///
+        /// algorithm: depth first search
+
+        void dfs_allpaths(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int end,
+            std::function<bool(const path_t &path, double cost)> visitor,
+            int maxLength = 0,
+            double maxCost = -1,
+            int threads = 1);
+
         /// @brief Find shortest path between 2 vertices, all edges count for 1
         /// @param gd
         /// @return vertex indices of path
@@ -305,6 +1225,100 @@ namespace raven
         std::vector<int>
         bfsPath(sGraphData &gd);
 
+        /// @brief Find shortest path between 2 vertices, all edges count for 1, using a workspace
+        /// @param gd
+        /// @param work
+        /// @return vertex indices of path
+
+        std::vector<int>
+        bfsPath(sGraphData &gd, cSearchWorkspace &work);
+
+        /// @brief breadth first search implementations
+        enum class bfs_engine
+        {
+            topdown,             // expand frontier through out links
+            directionOptimizing, // switch to bottom up parent search for large frontiers
+            parallel,            // expand large frontiers on every core
+        };
+
+        /// @brief breadth first search with selectable implementation
+        /// @param g
+        /// @param startIndex
+        /// @param visitor function to call when a new node is reached
+        /// @param engine
+        /// visitor should return true, but false if the search should stop
+
+        void bfs(
+            const cGraph &g,
+            int startIndex,
+            std::function<bool(int v)> visitor,
+            bfs_engine engine);
+
+        /// @brief Find shortest path between 2 vertices, all edges count for 1, with selectable implementation
+        /// @param gd
+        /// @param engine
+        /// @return vertex indices of path
+
+        std::vector<int>
+        bfsPath(sGraphData &gd, bfs_engine engine);
+
+        /// @brief direction optimizing breadth first search
+        /// @param g
+        /// @param edgeWeight links with zero weight are not used, empty to use every link
+        /// @param start vertex index
+        /// @param dest vertex index to stop at, -1 to reach every vertex
+        /// @param[out] pred vertex each vertex was reached from, -1 for start and vertices not reached
+        /// @param visitor optional function to call when a new node is reached, return false to stop
+        /// @return number of links inspected
+        ///
+        /// Levels with small frontiers are expanded top down through the out links.
+        /// When the frontier links outnumber a fraction of the unexplored links
+        /// the search switches to bottom up, where each unreached vertex looks through its in links
+        /// for a parent in the frontier, which is held as a bitmap.
+        /// Low diameter graphs reach most vertices in a few levels
+        /// and the bottom up levels stop inspecting links as soon as a parent is found.
+        ///
+        /// Vertices are visited level by level, but within a bottom up level in vertex index order.
+        ///
+        /// Scott Beamer, Krste Asanović, David Patterson, "Direction-Optimizing Breadth-First Search", SC 2012
+
+        long long bfsDirectionOptimizing(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int dest,
+            std::vector<int> &pred,
+            std::function<bool(int v)> visitor = nullptr);
+
+        /// @brief level synchronous multithreaded breadth first search
+        /// @param g
+        /// @param edgeWeight links with zero weight are not used, empty to use every link
+        /// @param start vertex index
+        /// @param dest vertex index to stop at, -1 to reach every vertex
+        /// @param[out] pred vertex each vertex was reached from, -1 for start and vertices not reached
+        /// @param visitor optional function to call when a new node is reached, return false to stop
+        /// @param threads number of threads, 0 for all cores
+        ///
+        /// Each level's frontier is shared between the threads,
+        /// which build local next frontiers, claiming vertices with atomic visited bits.
+        /// Where several frontier vertices reach the same vertex
+        /// the one earliest in the frontier wins, as it does in a sequential search,
+        /// and the next frontier is sorted into sequential order.
+        /// So the visit order and the predecessors are the same as bfsPath() produces.
+        /// When dest is reached the level is completed, so vertices found later in that level
+        /// have predecessors that bfsPath() would not have set.
+        ///
+        /// Small frontiers are expanded by the calling thread.
+
+        void bfsParallel(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int dest,
+            std::vector<int> &pred,
+            std::function<bool(int v)> visitor = nullptr,
+            int threads = 0);
+
         /// @brief path visiting every node
 
         std::vector<int>
@@ -325,10 +1339,154 @@ namespace raven
         /// @return vector of vectors of vertex indices in each component
         ///
         /// the vertices in a component are all reachable from each other
+        /// For directed graphs these are the strongly connected components, see strongComponents()
 
         std::vector<path_t> components(
             const cGraph &g);
 
+        /// @brief find components, using a workspace
+        /// @param g
+        /// @param work
+        /// @return vector of vectors of vertex indices in each component
+
+        std::vector<path_t> components(
+            const cGraph &g,
+            cSearchWorkspace &work);
+
+        /// @brief label connected components, using several threads
+        /// @param g
+        /// @param threads number of threads, 0 for all cores
+        /// @return component index of each vertex, numbered from 0 in order of their lowest vertex index
+        ///
+        /// Links are treated as undirected, so for directed graphs these are the weakly connected components.
+        /// algorithm: concurrent union find, lock free with compare and swap linking and path halving
+        /// Small graphs are labelled by the calling thread.
+
+        std::vector<int> componentLabels(
+            const cGraph &g,
+            int threads = 0);
+
+        /// @brief label connected components of a link list, using several threads
+        /// @param vertexCount
+        /// @param links vertex index pairs
+        /// @param threads number of threads, 0 for all cores
+        /// @return component index of each vertex, numbered from 0 in order of their lowest vertex index
+
+        std::vector<int> componentLabels(
+            int vertexCount,
+            const std::vector<std::pair<int, int>> &links,
+            int threads = 0);
+
+        /// @brief group vertices by component label
+        /// @param label component index of each vertex, from componentLabels()
+        /// @return vertex indices in each component, in increasing order
+
+        std::vector<path_t> componentGroups(
+            const std::vector<int> &label);
+
+        /// @brief label strongly connected components
+        /// @param g directed graph
+        /// @return component index of each vertex
+        ///
+        /// In a strongly connected component every vertex can reach every other.
+        /// Components are numbered in topological order,
+        /// so every link between components goes from a lower to a higher index.
+        /// For an undirected graph these are the connected components.
+        /// algorithm: Tarjan, with an explicit stack so there is no recursion depth limit
+
+        std::vector<int> strongComponents(const cGraph &g);
+
+        /// @brief condensation of a graph
+        /// @param g directed graph
+        /// @param label component index of each vertex, from strongComponents()
+        /// @return directed acyclic graph with a vertex for each component, vertex index is component index,
+        /// and a link wherever a link in g joins two components
+
+        cGraph condensation(
+            const cGraph &g,
+            const std::vector<int> &label);
+
+        /// @brief Connectivity of a graph that changes, link by link
+        ///
+        /// Usage:
+        /// <pre>
+        ///    cDynamicConnectivity dc;
+        ///    dc.add(0, 1);
+        ///    dc.add(1, 2);
+        ///    if (dc.connected(0, 2))
+        ///        ...
+        /// </pre>
+        ///
+        /// Links are undirected, vertices are added as they are mentioned.
+        /// Adding a link and answering a query take near constant amortized time ( union find ).
+        ///
+        /// In deletion mode the links are also stored in an adjacency list,
+        /// and removing a link that joined a component marks the union find stale.
+        /// The next query rebuilds it, O(V+E), so batches of removals cost one rebuild.
+
+        class cDynamicConnectivity
+        {
+        public:
+            /// @brief CTOR
+            /// @param vertexCount number of vertices expected, more are added as needed
+            /// @param fDeletions true if links can be removed
+            cDynamicConnectivity(
+                int vertexCount = 0,
+                bool fDeletions = false);
+
+            /// @brief add a link
+            /// @param u vertex index
+            /// @param v vertex index
+            void add(int u, int v);
+
+            /// @brief remove a link, needs deletion mode
+            /// @param u vertex index
+            /// @param v vertex index
+            void remove(int u, int v);
+
+            /// @brief true if a path joins two vertices
+            bool connected(int u, int v);
+
+            /// @brief number of connected components, counting isolated vertices
+            int componentCount();
+
+            int vertexCount() const
+            {
+                return myParent.size();
+            }
+
+            /// @brief apply operations from an edge stream
+            /// @param is stream of lines "1 u v" to add a link, "0 u v" to remove it.
+            /// A header line "# V E" adds V vertices, other lines starting '#' are ignored.
+            /// Any other line that does not parse raises an exception.
+            /// @param batchSize number of operations in a batch
+            /// @param visitor called after each batch with the number of operations so far,
+            /// and after the last operation. Should return true, but false to stop reading.
+            /// @return number of operations applied
+            ///
+            /// This reads the dyngraphlab .graph.seq format
+
+            int read(
+                std::istream &is,
+                int batchSize,
+                std::function<bool(int opCount)> visitor);
+
+        private:
+            bool myfDeletions;
+            bool myfStale;
+            int myComponentCount;
+            std::vector<int> myParent;
+            std::vector<int> mySize;
+
+            // links, for rebuilding after a removal
+            std::vector<std::vector<int>> myAdjacent;
+
+            void grow(int v);
+            int root(int v);
+            void unite(int u, int v);
+            void rebuild();
+        };
+
         /// @brief Maximum flow between two vertices
         /// @param gd  graph data
         /// @param[out] vEdgeFlow flow through each edge
@@ -347,9 +1505,11 @@ namespace raven
 
         /// @brief Find connected source and sinks
         /// @param g the graph
+        /// @param edgeWeight not used, every link connects
         /// @return A vector of vectors containing a source index and the connected sink indices
         ///
         /// A source has a zero in-degree, a sink has a zero out-degree
+        /// Reachability is searched on the condensation, so each strongly connected component is visited once per source
 
         std::vector<std::vector<int>> sourceToSink(
             const cGraph &g,
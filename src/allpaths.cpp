@@ -0,0 +1,223 @@
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// @brief adjacency snapshot with link costs, shared read only by the search threads
+        struct sAdjacency_allpaths
+        {
+            std::vector<std::vector<int>> vAdj;
+            std::vector<std::vector<double>> vCost;
+
+            sAdjacency_allpaths(
+                const cGraph &g,
+                const std::vector<double> &edgeWeight)
+                : vAdj(g.vertexCount()),
+                  vCost(g.vertexCount())
+            {
+                for (int v = 0; v < g.vertexCount(); v++)
+                {
+                    vAdj[v] = g.adjacentOut(v);
+                    for (int w : vAdj[v])
+                    {
+                        if (edgeWeight.size())
+                            vCost[v].push_back(edgeWeight[g.find(v, w)]);
+                        else
+                            vCost[v].push_back(1);
+                    }
+                }
+            }
+        };
+
+        /// @brief search for paths from a partial path
+        /// @param adj adjacency snapshot
+        /// @param end vertex index
+        /// @param path partial path to extend, the search stack
+        /// @param cost cost of partial path
+        /// @param visitor called for each path
+        /// @param maxLength maximum number of links, 0 for no limit
+        /// @param maxCost maximum cost, negative for no limit
+        /// @param stop set true to stop every search
+        ///
+        /// Neighbours are explored last first, the order the original stack based search used
+
+        static void search_allpaths(
+            const sAdjacency_allpaths &adj,
+            int end,
+            path_t &path,
+            double cost,
+            const std::function<bool(const path_t &path, double cost)> &visitor,
+            int maxLength,
+            double maxCost,
+            std::atomic<bool> &stop)
+        {
+            // true for vertices on the search stack
+            std::vector<bool> onPath(adj.vAdj.size(), false);
+            for (int v : path)
+                onPath[v] = true;
+
+            // next neighbour to explore from each vertex on the stack
+            // and the cost of the path up to each vertex
+            std::vector<int> vNext;
+            std::vector<double> vCost;
+            vNext.push_back(adj.vAdj[path.back()].size());
+            vCost.push_back(cost);
+
+            if (path.back() == end)
+            {
+                if (!visitor(path, cost))
+                    stop = true;
+                return;
+            }
+
+            int rootLength = path.size();
+            while (path.size() >= rootLength && !stop)
+            {
+                int v = path.back();
+                int &next = vNext.back();
+                if (next == 0)
+                {
+                    // all neighbours explored, backtrack
+                    onPath[v] = false;
+                    path.pop_back();
+                    vNext.pop_back();
+                    vCost.pop_back();
+                    continue;
+                }
+                next--;
+
+                int w = adj.vAdj[v][next];
+                if (onPath[w])
+                    continue;
+                double wcost = vCost.back() + adj.vCost[v][next];
+
+                // prune partial paths that exceed the limits
+                if (maxCost >= 0 && wcost > maxCost)
+                    continue;
+                if (maxLength > 0 && path.size() > maxLength)
+                    continue;
+
+                if (w == end)
+                {
+                    path.push_back(w);
+                    if (!visitor(path, wcost))
+                        stop = true;
+                    path.pop_back();
+                    continue;
+                }
+
+                // go deeper
+                path.push_back(w);
+                onPath[w] = true;
+                vNext.push_back(adj.vAdj[w].size());
+                vCost.push_back(wcost);
+            }
+        }
+
+        void dfs_allpaths(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int end,
+            std::function<bool(const path_t &path, double cost)> visitor,
+            int maxLength,
+            double maxCost,
+            int threads)
+        {
+            if (0 > start || start >= g.vertexCount() ||
+                0 > end || end >= g.vertexCount())
+                throw std::runtime_error(
+                    "dfs_allpaths: bad start or end");
+            if (edgeWeight.size() && edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "dfs_allpaths: bad edge weights");
+
+            sAdjacency_allpaths adj(g, edgeWeight);
+            std::atomic<bool> stop(false);
+
+            if (threads == 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 1 || start == end)
+            {
+                path_t path{start};
+                search_allpaths(
+                    adj, end, path, 0,
+                    visitor, maxLength, maxCost, stop);
+                return;
+            }
+
+            /* fan out the first level branches across the threads
+
+            Each thread takes the next unexplored branch from the start vertex
+            and searches it with its own stack
+            */
+
+            // once the visitor asks to stop, paths found by other threads are not reported
+            std::mutex visitorMutex;
+            auto serialVisitor = [&](const path_t &path, double cost) -> bool
+            {
+                std::lock_guard<std::mutex> lock(visitorMutex);
+                if (stop)
+                    return false;
+                if (!visitor(path, cost))
+                    stop = true;
+                return !stop;
+            };
+
+            const auto &branch = adj.vAdj[start];
+            std::atomic<int> nextBranch(0);
+            auto worker = [&]()
+            {
+                path_t path;
+                while (!stop)
+                {
+                    int k = nextBranch++;
+                    if (k >= branch.size())
+                        break;
+                    if (branch[k] == start)
+                        continue;
+                    double cost = adj.vCost[start][k];
+                    if (maxCost >= 0 && cost > maxCost)
+                        continue;
+                    path = {start, branch[k]};
+                    search_allpaths(
+                        adj, end, path, cost,
+                        serialVisitor, maxLength, maxCost, stop);
+                }
+            };
+
+            std::vector<std::thread> vThread;
+            for (int t = 0; t < threads; t++)
+                vThread.emplace_back(worker);
+            for (auto &t : vThread)
+                t.join();
+        }
+
+        std::vector<std::vector<int>>
+        dfs_allpaths(sGraphData &gd)
+        {
+            int start = gd.g.find(gd.startName);
+            int end = gd.g.find(gd.endName);
+            if (start < 0 || end < 0)
+                throw std::runtime_error(
+                    "dfs_allpaths: bad start or end");
+
+            std::vector<std::vector<int>> ret;
+            dfs_allpaths(
+                gd.g,
+                {},
+                start, end,
+                [&](const path_t &path, double cost)
+                {
+                    ret.push_back(path);
+                    return true;
+                });
+            return ret;
+        }
+    }
+}
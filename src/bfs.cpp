@@ -0,0 +1,382 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// @brief a bit for every vertex
+        class cBitmap_bfs
+        {
+        public:
+            cBitmap_bfs(int n)
+                : myWord((n + 63) / 64, 0)
+            {
+            }
+            bool test(int v) const
+            {
+                return (myWord[v >> 6] >> (v & 63)) & 1;
+            }
+            void set(int v)
+            {
+                myWord[v >> 6] |= uint64_t(1) << (v & 63);
+            }
+            void clear()
+            {
+                std::fill(myWord.begin(), myWord.end(), 0);
+            }
+
+        private:
+            std::vector<uint64_t> myWord;
+        };
+
+        long long bfsDirectionOptimizing(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int dest,
+            std::vector<int> &pred,
+            std::function<bool(int v)> visitor)
+        {
+            // tuning parameters from Beamer et al
+            const int alpha = 14;
+            const int beta = 24;
+
+            int n = g.vertexCount();
+            if (0 > start || start >= n)
+                throw std::runtime_error(
+                    "bfsDirectionOptimizing bad start");
+            if (edgeWeight.size() && edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "bfsDirectionOptimizing bad edge weights");
+
+            // check link usable
+            auto usable = [&](int u, int v) -> bool
+            {
+                if (!edgeWeight.size())
+                    return true;
+                return edgeWeight[g.find(u, v)] != 0;
+            };
+
+            long long inspected = 0;
+
+            pred.clear();
+            pred.resize(n, -1);
+            if (visitor && !visitor(start))
+                return inspected;
+            if (start == dest)
+                return inspected;
+
+            cBitmap_bfs visited(n);
+            cBitmap_bfs frontierBits(n);
+            visited.set(start);
+
+            // current level vertices, and the next level being built
+            std::vector<int> frontier{start};
+            std::vector<int> next;
+
+            // links out of the frontier, links out of unreached vertices
+            long long mf = g.adjacentOutRef(start).size();
+            long long mu = -mf;
+            for (int v = 0; v < n; v++)
+                mu += g.adjacentOutRef(v).size();
+
+            bool bottomUp = false;
+
+            while (frontier.size())
+            {
+                // choose direction for this level
+                if (!bottomUp && mf > mu / alpha)
+                    bottomUp = true;
+                else if (bottomUp && frontier.size() < n / beta)
+                    bottomUp = false;
+
+                next.clear();
+                bool stop = false;
+
+                if (!bottomUp)
+                {
+                    // top down: look for unreached vertices from the frontier
+                    for (int u : frontier)
+                    {
+                        for (int v : g.adjacentOutRef(u))
+                        {
+                            inspected++;
+                            if (visited.test(v))
+                                continue;
+                            if (!usable(u, v))
+                                continue;
+                            visited.set(v);
+                            pred[v] = u;
+                            next.push_back(v);
+                            if ((visitor && !visitor(v)) || v == dest)
+                            {
+                                stop = true;
+                                break;
+                            }
+                        }
+                        if (stop)
+                            break;
+                    }
+                }
+                else
+                {
+                    // bottom up: look for a parent in the frontier for every unreached vertex
+                    frontierBits.clear();
+                    for (int u : frontier)
+                        frontierBits.set(u);
+
+                    for (int v = 0; v < n && !stop; v++)
+                    {
+                        if (visited.test(v))
+                            continue;
+                        for (int u : g.adjacentInRef(v))
+                        {
+                            inspected++;
+                            if (!frontierBits.test(u))
+                                continue;
+                            if (!usable(u, v))
+                                continue;
+                            visited.set(v);
+                            pred[v] = u;
+                            next.push_back(v);
+                            if ((visitor && !visitor(v)) || v == dest)
+                                stop = true;
+                            break;
+                        }
+                    }
+                }
+                if (stop)
+                    break;
+
+                // advance to next level
+                frontier.swap(next);
+                mf = 0;
+                for (int v : frontier)
+                    mf += g.adjacentOutRef(v).size();
+                mu -= mf;
+            }
+
+            return inspected;
+        }
+
+        void bfsParallel(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start,
+            int dest,
+            std::vector<int> &pred,
+            std::function<bool(int v)> visitor,
+            int threads)
+        {
+            // frontiers smaller than this are expanded by the calling thread
+            const int parallelFrontier = 1024;
+
+            int n = g.vertexCount();
+            if (0 > start || start >= n)
+                throw std::runtime_error(
+                    "bfsParallel bad start");
+            if (edgeWeight.size() && edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "bfsParallel bad edge weights");
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 0)
+                threads = 1;
+
+            pred.clear();
+            pred.resize(n, -1);
+            if (visitor && !visitor(start))
+                return;
+
+            // vertices reached in previous levels, only changed between levels
+            std::vector<char> visited(n, 0);
+            visited[start] = 1;
+
+            // vertices claimed in the current level
+            std::vector<std::atomic<uint64_t>> claimed((n + 63) / 64);
+            for (auto &w : claimed)
+                w = 0;
+
+            /* discovery key of each vertex claimed in current level
+
+            frontier position of the discoverer in the high 32 bits,
+            index of vertex in discoverer's adjacency list in low 32 bits.
+            The smallest key is the discovery a sequential search would make first
+            */
+            std::vector<std::atomic<uint64_t>> key(n);
+            for (auto &k : key)
+                k = UINT64_MAX;
+
+            std::vector<int> frontier{start};
+            std::vector<std::vector<int>> vLocalNext(threads);
+
+            // expand part of the frontier
+            auto expand = [&](int first, int last, std::vector<int> &localNext)
+            {
+                for (int pos = first; pos < last; pos++)
+                {
+                    int u = frontier[pos];
+                    const auto &adj = g.adjacentOutRef(u);
+                    for (int k = 0; k < adj.size(); k++)
+                    {
+                        int v = adj[k];
+                        if (visited[v])
+                            continue;
+                        if (edgeWeight.size() && edgeWeight[g.find(u, v)] == 0)
+                            continue;
+
+                        // keep the earliest discovery
+                        uint64_t mykey = (uint64_t(pos) << 32) | uint64_t(k);
+                        uint64_t cur = key[v].load();
+                        while (mykey < cur &&
+                               !key[v].compare_exchange_weak(cur, mykey))
+                            ;
+
+                        // claim vertex, first claim this level adds it to a local next frontier
+                        uint64_t bit = uint64_t(1) << (v & 63);
+                        if (!(claimed[v >> 6].fetch_or(bit) & bit))
+                            localNext.push_back(v);
+                    }
+                }
+            };
+
+            while (frontier.size())
+            {
+                for (auto &ln : vLocalNext)
+                    ln.clear();
+
+                if (threads == 1 || frontier.size() < parallelFrontier)
+                    expand(0, frontier.size(), vLocalNext[0]);
+                else
+                {
+                    std::vector<std::thread> vThread;
+                    int chunk = (frontier.size() + threads - 1) / threads;
+                    for (int t = 0; t < threads; t++)
+                    {
+                        int first = t * chunk;
+                        int last = std::min((int)frontier.size(), first + chunk);
+                        if (first >= last)
+                            break;
+                        vThread.emplace_back(
+                            expand, first, last, std::ref(vLocalNext[t]));
+                    }
+                    for (auto &t : vThread)
+                        t.join();
+                }
+
+                // merge local frontiers into sequential discovery order
+                std::vector<int> next;
+                for (auto &ln : vLocalNext)
+                    next.insert(next.end(), ln.begin(), ln.end());
+                std::sort(
+                    next.begin(), next.end(),
+                    [&](int a, int b)
+                    {
+                        return key[a].load() < key[b].load();
+                    });
+
+                bool stop = false;
+                for (int v : next)
+                {
+                    pred[v] = frontier[key[v].load() >> 32];
+                    visited[v] = 1;
+                    claimed[v >> 6] = 0;
+                }
+                for (int v : next)
+                {
+                    if ((visitor && !visitor(v)) || v == dest)
+                    {
+                        stop = true;
+                        break;
+                    }
+                }
+                if (stop)
+                    break;
+
+                frontier.swap(next);
+            }
+        }
+
+        void bfs(
+            const cGraph &g,
+            int startIndex,
+            std::function<bool(int v)> visitor,
+            bfs_engine engine)
+        {
+            switch (engine)
+            {
+            case bfs_engine::topdown:
+                bfs(g, startIndex, visitor);
+                break;
+
+            case bfs_engine::directionOptimizing:
+            {
+                std::vector<int> pred;
+                bfsDirectionOptimizing(
+                    g, {}, startIndex, -1,
+                    pred, visitor);
+            }
+            break;
+
+            case bfs_engine::parallel:
+            {
+                std::vector<int> pred;
+                bfsParallel(
+                    g, {}, startIndex, -1,
+                    pred, visitor);
+            }
+            break;
+            }
+        }
+
+        std::vector<int>
+        bfsPath(sGraphData &gd, bfs_engine engine)
+        {
+            if (engine == bfs_engine::topdown)
+                return bfsPath(gd);
+
+            // the path will be stored here
+            std::vector<int> path;
+
+            if (!gd.edgeWeight.size())
+                gd.edgeWeight.resize(gd.g.edgeCount(), 1);
+
+            // get vertex indices from user names
+            int start = gd.g.find(gd.startName);
+            int dest = gd.g.find(gd.endName);
+            if (start < 0 || dest < 0)
+                throw std::runtime_error(
+                    "cGraph::bfsPath bad start or destination");
+
+            std::vector<int> pred;
+            if (engine == bfs_engine::parallel)
+                bfsParallel(
+                    gd.g, gd.edgeWeight, start, dest,
+                    pred);
+            else
+                bfsDirectionOptimizing(
+                    gd.g, gd.edgeWeight, start, dest,
+                    pred);
+
+            if (pred[dest] == -1)
+            {
+                // destination not reachable
+                return path;
+            }
+
+            // extract path by backtracking from destination to start
+            for (int v = dest; v != start; v = pred[v])
+                path.push_back(v);
+            path.push_back(start);
+
+            // flip path to start -> destination
+            std::reverse(path.begin(), path.end());
+
+            return path;
+        }
+    }
+}
@@ -20,6 +20,17 @@ namespace raven
             vVertexAttr.clear();
             vVertexName.clear();
             mapEdge.clear();
+            vEdgeEnds.clear();
+            lastEdgeIndex = -1;
+        }
+        void cGraph::removeLinks()
+        {
+            for (auto &v : vOutVertices)
+                v.clear();
+            for (auto &v : vInVertices)
+                v.clear();
+            mapEdge.clear();
+            vEdgeEnds.clear();
             lastEdgeIndex = -1;
         }
         int cGraph::add(const std::string &name)
@@ -34,6 +45,19 @@ namespace raven
             return vVertexName.size() - 1;
         }
 
+        int cGraph::addVertices(int count, const std::string &prefix)
+        {
+            int first = vVertexName.size();
+            int n = first + count;
+            vOutVertices.resize(n);
+            vInVertices.resize(n);
+            vVertexAttr.resize(n);
+            vVertexName.reserve(n);
+            for (int v = first; v < n; v++)
+                vVertexName.push_back(prefix + std::to_string(v));
+            return first;
+        }
+
         int cGraph::add(const std::string &src, const std::string &dst)
         {
             // find or add the vertices
@@ -72,6 +96,7 @@ namespace raven
             vInVertices[d].push_back(s);
             lastEdgeIndex++;
             mapEdge.insert(mapEdge_t::value_type(std::make_pair(s, d), lastEdgeIndex));
+            vEdgeEnds.push_back(std::make_pair(s, d));
 
             if (fDirected)
                 return lastEdgeIndex;
@@ -81,6 +106,7 @@ namespace raven
             vInVertices[s].push_back(d);
             lastEdgeIndex++;
             mapEdge.insert(mapEdge_t::value_type(std::make_pair(d, s), lastEdgeIndex));
+            vEdgeEnds.push_back(std::make_pair(d, s));
 
             return lastEdgeIndex - 1;
         }
@@ -115,7 +141,10 @@ namespace raven
             if (it != vInVertices[d].end())
                 vInVertices[d].erase(it);
 
-            mapEdge.erase(mapEdge.find(std::make_pair(s, d)));
+            // find() gives the index of the lower source for undirected graphs, so look up s -> d itself
+            auto ite = mapEdge.find(std::make_pair(s, d));
+            vEdgeEnds[ite->second] = std::make_pair(-1, -1);
+            mapEdge.erase(ite);
 
             if (fDirected)
                 return;
@@ -126,7 +155,9 @@ namespace raven
             it = std::find(vInVertices[s].begin(), vInVertices[s].end(), d);
             if (it != vInVertices[s].end())
                 vInVertices[s].erase(it);
-            mapEdge.erase(mapEdge.find(std::make_pair(d, s)));
+            ite = mapEdge.find(std::make_pair(d, s));
+            vEdgeEnds[ite->second] = std::make_pair(-1, -1);
+            mapEdge.erase(ite);
         }
         void cGraph::remove(const std::string &src, const std::string &dst)
         {
@@ -209,21 +240,15 @@ namespace raven
 
         int cGraph::dest(int ei) const
         {
-            auto it = mapEdge.begin();
-            for (; it != mapEdge.end(); it++)
-                if (it->second == ei)
-                    return it->first.second;
-
-            return -1;
+            if (0 > ei || ei >= vEdgeEnds.size())
+                return -1;
+            return vEdgeEnds[ei].second;
         }
         int cGraph::src(int ei) const
         {
-            auto it = mapEdge.begin();
-            for (; it != mapEdge.end(); it++)
-                if (it->second == ei)
-                    return it->first.first;
-
-            return -1;
+            if (0 > ei || ei >= vEdgeEnds.size())
+                return -1;
+            return vEdgeEnds[ei].first;
         }
         std::string cGraph::rVertexAttr(int vi, int ai) const
         {
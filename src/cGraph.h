@@ -25,6 +25,16 @@ namespace raven
 
             int add(const std::string &name);
 
+            /* @brief add new vertices named by their index
+            /// @param count number of vertices to add
+            /// @param prefix start of each name, the vertex index follows
+            /// @return index of the first vertex added
+
+            There is no duplicate name check, so this is quick for large graphs.
+            The names must not already be in use
+            */
+            int addVertices(int count, const std::string &prefix = "");
+
             /* @brief add a new edge between named vertices
             /// @param scr name
             /// @param dst name
@@ -62,6 +72,9 @@ namespace raven
             /// remove vertex
             void remove(int removed);
 
+            /// remove every link, keeping the vertices and their attributes
+            void removeLinks();
+
             /////////////////////// getters
 
             bool isDirected() const { return fDirected; }
@@ -95,6 +108,26 @@ namespace raven
             /// @return 
             std::vector<int> adjacentIn(int vi) const;
 
+            /// @brief vertices reachable by one hop, without copying
+            /// @param vi
+            /// @return reference to adjacency list, invalidated by any change to the graph
+            ///
+            /// No index check, for use in tight loops
+            const std::vector<int> &adjacentOutRef(int vi) const
+            {
+                return vOutVertices[vi];
+            }
+
+            /// @brief vertices that can reach with one hop, without copying
+            /// @param vi
+            /// @return reference to adjacency list, invalidated by any change to the graph
+            ///
+            /// No index check, for use in tight loops
+            const std::vector<int> &adjacentInRef(int vi) const
+            {
+                return vInVertices[vi];
+            }
+
             // get vertex index of edge destination
             int dest(int ei) const;
 
@@ -129,6 +162,9 @@ namespace raven
             typedef std::map<std::pair<int, int>, int> mapEdge_t;
             mapEdge_t mapEdge;
 
+            // vEdgeEnds[ei] is the src, dst of edge index ei, -1, -1 if removed
+            std::vector<std::pair<int, int>> vEdgeEnds;
+
             
             /** vertex attributes
              *
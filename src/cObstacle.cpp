@@ -164,7 +164,7 @@ void cObstacle::connect()
             int dy = h1 - h2;
             int d2 = dx * dx + dy * dy;
             myEdgeWeight[mygraphdata.add(sn1, sn2)] = d2;
-            myEdgeWeight[mygraphdata.add(sn2, sn2)] = d2;
+            myEdgeWeight[mygraphdata.add(sn2, sn1)] = d2;
         }
 }
 
@@ -182,9 +182,17 @@ void cObstacle::tourNodes()
               << ", nodes " << mygraphdata.vertexCount()
               << "\n";
 
+    // remove avoidable revisits and backtracks
+    auto opt = raven::graph::tourOptimize(
+        mygraphdata,
+        myEdgeWeight,
+        myRouteCalculator.getTour());
+    std::cout << "optimized tour " << opt.first.size()
+              << " steps, cost " << opt.second << "\n";
+
     myTour.clear();
     std::tuple<std::string, int, int> loc;
-    for (int n : myRouteCalculator.getTour())
+    for (int n : opt.first)
     {
         std::get<0>(loc) = mygraphdata.userName(n);
         A->coords(
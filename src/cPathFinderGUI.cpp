@@ -247,7 +247,13 @@ void cGUI::calcCost()
 
 void cGUI::calcSpan()
 {
-    myResultGraph = spanningTree(myGraphData);
+    // a tree for every connected component, no start vertex needed
+    auto weight = myGraphData.edgeWeight;
+    if (weight.size() < 2 * myGraphData.g.edgeCount())
+        weight.resize(2 * myGraphData.g.edgeCount(), 1);
+    myResultGraph = spanningGraph(
+        myGraphData.g,
+        spanningForestBoruvka(myGraphData.g, weight));
 
     myViewType = eView::span;
     auto viz = pathViz(
@@ -314,39 +320,87 @@ void cGUI::calcSales()
 {
     myResultText = "Sales calcultion NYI";
 
-    if (myGraphData.g.rVertexAttr(0, 1) == "")
-    {
-        // link specification
-    }
-    else
+    // exact tour when dynamic programming, or else branch and bound, is quick enough
+    const int heldKarpCities = 20;
+    const int exactCities = 30;
+
+    // time allowed to branch and bound, before falling back to a tour that may not be the cheapest
+    const double exactSeconds = 2;
+
+    // time allowed to improve a tour through many cities
+    const double tourSeconds = 2;
+
+    if (myGraphData.g.rVertexAttr(0, 1) != "")
     {
         // city location specification
-        // link all cities with the square of the pythogorean distance between their locations
-        myGraphData.edgeWeight.clear();
-        myGraphData.edgeWeight.resize(myGraphData.g.vertexCount()*myGraphData.g.vertexCount(),INT_MAX);
-        for (int v1 = 0; v1 < myGraphData.g.vertexCount(); v1++)
+        // every pair of cities linked by a straight line, distances found when needed
+        raven::graph::cEuclideanGraph cities(myGraphData.g);
+        raven::graph::path_t tour;
+        if (cities.vertexCount() <= exactCities)
         {
-            double x1 = atof(myGraphData.g.rVertexAttr(v1, 0).c_str());
-            double y1 = atof(myGraphData.g.rVertexAttr(v1, 1).c_str());
-            for (int v2 = v1 + 1; v2 < myGraphData.g.vertexCount(); v2++)
-            {
-                double x2 = atof(myGraphData.g.rVertexAttr(v2, 0).c_str());
-                double y2 = atof(myGraphData.g.rVertexAttr(v2, 1).c_str());
-                double dx = x2 - x1;
-                double dy = y2 - y1;
-                double dsq = dx * dx + dy * dy;
-                myGraphData.edgeWeight[myGraphData.g.add(v1, v2)] = dsq;
-            }
+            raven::graph::cTSP tsp(cities);
+            if (cities.vertexCount() <= heldKarpCities)
+                tour = tsp.calculateHeldKarp();
+            else
+                tour = tsp.calculate(0, exactSeconds);
+        }
+        if (!tour.size())
+        {
+            // many cities, or out of time, searched near each city
+            tour = raven::graph::tourCities(
+                       raven::graph::cSpatialIndex(cities.x(), cities.y()),
+                       tourSeconds)
+                       .first;
+        }
+
+        // link the cities along the tour, for display
+        double length = 0;
+        myGraphData.g.removeLinks();
+        for (int k = 1; k < tour.size(); k++)
+        {
+            myGraphData.g.add(tour[k - 1], tour[k]);
+            length += cities.edgeWeight(tour[k - 1], tour[k]);
         }
+
+        myResultText = "Tour length = " + std::to_string(length);
+        RunDOT(
+            myGraphData.g,
+            pathViz(
+                myGraphData.g,
+                tour,
+                true));
+        return;
     }
 
-    calcTour();
+    // link specification
+    std::vector<int> tour;
+    if (myGraphData.g.vertexCount() <= exactCities)
+    {
+        raven::graph::cTSP tsp(myGraphData.g, myGraphData.edgeWeight);
+        if (myGraphData.g.vertexCount() <= heldKarpCities)
+            tour = tsp.calculateHeldKarp();
+        else
+            tour = tsp.calculate(0, exactSeconds);
+        if (tour.size())
+        {
+            myResultText = "";
+            for (int v : tour)
+                myResultText += myGraphData.g.userName(v) + " -> ";
+            myResultText += " Cost = " + std::to_string(tsp.TotalPathEdgeWeight());
+        }
+    }
+    if (!tour.size())
+    {
+        // too many cities, out of time, or no tour visits each city once, so allow revisits
+        calcTour();
+        tour = mypTourNodes->getTour();
+    }
 
     RunDOT(
         myGraphData.g,
         pathViz(
             myGraphData.g,
-            mypTourNodes->getTour(),
+            tour,
             true));
 }
 
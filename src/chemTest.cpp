@@ -15,6 +15,20 @@ TEST(cyclohexane)
     CHECK_EQUAL("C1CCCCC1",act);
 }
 
+TEST(doubleBondReversed)
+{
+    // double bond added from the higher vertex index
+    raven::graph::cGraph ingraph;
+    ingraph.add("C1");
+    ingraph.add("C2");
+    ingraph.add("C2", "O1");
+    std::vector<int> bondtype(2 * ingraph.edgeCount() + 2, 1);
+    bondtype[ingraph.add("C2", "C1")] = 2;
+
+    auto act = SMILES(ingraph, bondtype);
+    CHECK_EQUAL("C=CO", act);
+}
+
 TEST(readSMILES)
 {
     raven::graph::cGraph g;
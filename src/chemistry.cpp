@@ -39,7 +39,18 @@ namespace raven
                     // check for double bond
                     if (prev != -1)
                     {
-                        if (bondtype[gd.g.find(prev, v)] == 2)
+                        // bond type is stored against the index add() returned, the link in the direction it was added.
+                        // find() gives the lower to higher vertex link of an undirected graph,
+                        // the link added in the other direction is the one before it
+                        int ei = gd.g.find(prev, v);
+                        if (ei > 0 && !gd.g.isDirected() &&
+                            gd.g.src(ei - 1) == gd.g.dest(ei) &&
+                            gd.g.dest(ei - 1) == gd.g.src(ei))
+                            ei--;
+
+                        // dfs can reach an atom that is not bonded to the previous atom
+                        if (0 <= ei && ei < bondtype.size() &&
+                            bondtype[ei] == 2)
                         {
                             SMILES += "=";
                             vLabel.push_back("-");
@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <atomic>
+#include <sstream>
+#include <thread>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// @brief root of the tree containing a vertex, halving the path on the way
+        /// @param parent
+        /// @param x vertex index
+        /// @return root vertex index
+
+        static int find_uf(
+            std::vector<std::atomic<int>> &parent,
+            int x)
+        {
+            while (true)
+            {
+                int p = parent[x].load();
+                if (p == x)
+                    return x;
+                int gp = parent[p].load();
+                if (p != gp)
+                {
+                    // point x at its grandparent, if another thread got there first no harm done
+                    parent[x].compare_exchange_weak(p, gp);
+                }
+                x = gp;
+            }
+        }
+
+        /// @brief merge the trees containing two vertices
+        /// @param parent
+        /// @param a vertex index
+        /// @param b vertex index
+        ///
+        /// The root with the higher index is linked below the lower,
+        /// so concurrent links can never make a loop
+
+        static void unite_uf(
+            std::vector<std::atomic<int>> &parent,
+            int a,
+            int b)
+        {
+            while (true)
+            {
+                a = find_uf(parent, a);
+                b = find_uf(parent, b);
+                if (a == b)
+                    return;
+                if (a < b)
+                    std::swap(a, b);
+                int expected = a;
+                if (parent[a].compare_exchange_strong(expected, b))
+                    return;
+                // a is no longer a root, another thread linked it, try again
+            }
+        }
+
+        void share(
+            int count,
+            int threads,
+            std::function<void(int first, int last, int t)> work,
+            int parallelItems)
+        {
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 1 || count < parallelItems)
+            {
+                work(0, count, 0);
+                return;
+            }
+            std::vector<std::thread> vThread;
+            int chunk = (count + threads - 1) / threads;
+            for (int t = 0; t < threads; t++)
+            {
+                int first = t * chunk;
+                int last = std::min(count, first + chunk);
+                if (first >= last)
+                    break;
+                vThread.emplace_back(work, first, last, t);
+            }
+            for (auto &t : vThread)
+                t.join();
+        }
+
+        /// @brief number the trees in vertex index order
+        /// @param parent
+        /// @return component index of each vertex
+
+        static std::vector<int> label_uf(
+            std::vector<std::atomic<int>> &parent)
+        {
+            /* every root is the lowest index in its tree,
+            so it is reached before any other vertex in its component
+            */
+            int n = parent.size();
+            std::vector<int> label(n);
+            int count = 0;
+            for (int v = 0; v < n; v++)
+            {
+                int r = find_uf(parent, v);
+                if (r == v)
+                    label[v] = count++;
+                else
+                    label[v] = label[r];
+            }
+            return label;
+        }
+
+        std::vector<int> componentLabels(
+            const cGraph &g,
+            int threads)
+        {
+            int n = g.vertexCount();
+            std::vector<std::atomic<int>> parent(n);
+            for (int v = 0; v < n; v++)
+                parent[v] = v;
+
+            // merge across the links from a range of vertices
+            share(
+                n, threads,
+                [&](int first, int last, int t)
+                {
+                    for (int v = first; v < last; v++)
+                        for (int w : g.adjacentOutRef(v))
+                            if (g.isDirected() || v < w)
+                                unite_uf(parent, v, w);
+                });
+
+            return label_uf(parent);
+        }
+
+        std::vector<int> componentLabels(
+            int vertexCount,
+            const std::vector<std::pair<int, int>> &links,
+            int threads)
+        {
+            std::vector<std::atomic<int>> parent(vertexCount);
+            for (int v = 0; v < vertexCount; v++)
+                parent[v] = v;
+
+            share(
+                links.size(), threads,
+                [&](int first, int last, int t)
+                {
+                    for (int k = first; k < last; k++)
+                        unite_uf(parent, links[k].first, links[k].second);
+                });
+
+            return label_uf(parent);
+        }
+
+        std::vector<int> strongComponents(const cGraph &g)
+        {
+            int n = g.vertexCount();
+
+            // discovery order of each vertex, -1 if not yet reached
+            std::vector<int> index(n, -1);
+
+            // lowest discovery order reachable from subtree still on stack
+            std::vector<int> low(n);
+
+            // vertices waiting for their component to be completed
+            std::vector<int> S;
+            std::vector<bool> onStack(n, false);
+
+            // component completion order of each vertex
+            std::vector<int> finish(n);
+            int finishCount = 0;
+
+            // search frame: vertex, next adjacency index
+            std::vector<std::pair<int, int>> stack;
+            int time = 0;
+
+            for (int root = 0; root < n; root++)
+            {
+                if (index[root] >= 0)
+                    continue;
+
+                index[root] = low[root] = time++;
+                S.push_back(root);
+                onStack[root] = true;
+                stack.push_back(std::make_pair(root, 0));
+
+                while (!stack.empty())
+                {
+                    int v = stack.back().first;
+                    auto &adj = g.adjacentOutRef(v);
+                    if (stack.back().second < adj.size())
+                    {
+                        int w = adj[stack.back().second++];
+                        if (index[w] < 0)
+                        {
+                            // tree link, search deeper
+                            index[w] = low[w] = time++;
+                            S.push_back(w);
+                            onStack[w] = true;
+                            stack.push_back(std::make_pair(w, 0));
+                        }
+                        else if (onStack[w])
+                            low[v] = std::min(low[v], index[w]);
+                        continue;
+                    }
+
+                    // all links from v searched
+                    stack.pop_back();
+                    if (low[v] == index[v])
+                    {
+                        // v is the first reached vertex of a component, which is complete
+                        while (true)
+                        {
+                            int w = S.back();
+                            S.pop_back();
+                            onStack[w] = false;
+                            finish[w] = finishCount;
+                            if (w == v)
+                                break;
+                        }
+                        finishCount++;
+                    }
+                    if (!stack.empty())
+                    {
+                        int u = stack.back().first;
+                        low[u] = std::min(low[u], low[v]);
+                    }
+                }
+            }
+
+            /* components complete after every component they link to,
+            so reverse the completion order to number in topological order
+            */
+            for (int v = 0; v < n; v++)
+                finish[v] = finishCount - 1 - finish[v];
+            return finish;
+        }
+
+        cGraph condensation(
+            const cGraph &g,
+            const std::vector<int> &label)
+        {
+            cGraph ret;
+            ret.directed();
+            int count = 0;
+            for (int c : label)
+                count = std::max(count, c + 1);
+            ret.addVertices(count);
+            for (int v = 0; v < g.vertexCount(); v++)
+                for (int w : g.adjacentOutRef(v))
+                    if (label[v] != label[w])
+                        ret.add(label[v], label[w]);
+            return ret;
+        }
+
+        cDynamicConnectivity::cDynamicConnectivity(
+            int vertexCount,
+            bool fDeletions)
+            : myfDeletions(fDeletions),
+              myfStale(false),
+              myComponentCount(0)
+        {
+            if (vertexCount > 0)
+                grow(vertexCount - 1);
+        }
+
+        void cDynamicConnectivity::grow(int v)
+        {
+            if (v < 0)
+                throw std::runtime_error(
+                    "cDynamicConnectivity bad vertex index");
+            while (v >= myParent.size())
+            {
+                myParent.push_back(myParent.size());
+                mySize.push_back(1);
+                myComponentCount++;
+            }
+            if (myfDeletions && myAdjacent.size() < myParent.size())
+                myAdjacent.resize(myParent.size());
+        }
+
+        int cDynamicConnectivity::root(int v)
+        {
+            while (myParent[v] != v)
+            {
+                // path halving
+                myParent[v] = myParent[myParent[v]];
+                v = myParent[v];
+            }
+            return v;
+        }
+
+        void cDynamicConnectivity::unite(int u, int v)
+        {
+            u = root(u);
+            v = root(v);
+            if (u == v)
+                return;
+
+            // smaller tree goes below larger
+            if (mySize[u] < mySize[v])
+                std::swap(u, v);
+            myParent[v] = u;
+            mySize[u] += mySize[v];
+            myComponentCount--;
+        }
+
+        void cDynamicConnectivity::rebuild()
+        {
+            for (int v = 0; v < myParent.size(); v++)
+            {
+                myParent[v] = v;
+                mySize[v] = 1;
+            }
+            myComponentCount = myParent.size();
+            for (int u = 0; u < myAdjacent.size(); u++)
+                for (int v : myAdjacent[u])
+                    if (u < v)
+                        unite(u, v);
+            myfStale = false;
+        }
+
+        void cDynamicConnectivity::add(int u, int v)
+        {
+            grow(std::max(u, v));
+            if (myfDeletions)
+            {
+                myAdjacent[u].push_back(v);
+                if (u != v)
+                    myAdjacent[v].push_back(u);
+            }
+            if (!myfStale)
+                unite(u, v);
+        }
+
+        void cDynamicConnectivity::remove(int u, int v)
+        {
+            if (!myfDeletions)
+                throw std::runtime_error(
+                    "cDynamicConnectivity::remove needs deletion mode");
+            if (u < 0 || v < 0 || u >= myParent.size() || v >= myParent.size())
+                return;
+
+            auto &au = myAdjacent[u];
+            auto it = std::find(au.begin(), au.end(), v);
+            if (it == au.end())
+                return;
+            *it = au.back();
+            au.pop_back();
+            if (u != v)
+            {
+                auto &av = myAdjacent[v];
+                *std::find(av.begin(), av.end(), u) = av.back();
+                av.pop_back();
+
+                // the components may have split
+                myfStale = true;
+            }
+        }
+
+        bool cDynamicConnectivity::connected(int u, int v)
+        {
+            if (u < 0 || v < 0 || u >= myParent.size() || v >= myParent.size())
+                return u == v;
+            if (myfStale)
+                rebuild();
+            return root(u) == root(v);
+        }
+
+        int cDynamicConnectivity::componentCount()
+        {
+            if (myfStale)
+                rebuild();
+            return myComponentCount;
+        }
+
+        int cDynamicConnectivity::read(
+            std::istream &is,
+            int batchSize,
+            std::function<bool(int opCount)> visitor)
+        {
+            int count = 0;
+            std::string line;
+            while (getline(is, line))
+            {
+                std::istringstream ss(line);
+                if (line.size() && line[0] == '#')
+                {
+                    // header "# V E" gives the vertex count, so isolated vertices are counted
+                    std::string hash;
+                    int vertexCount;
+                    if (ss >> hash >> vertexCount && hash == "#" && vertexCount > 0)
+                        grow(vertexCount - 1);
+                    continue;
+                }
+                if (line.find_first_not_of(" \t\r") == std::string::npos)
+                    continue;
+                int op, u, v;
+                if (!(ss >> op >> u >> v))
+                    throw std::runtime_error(
+                        "cDynamicConnectivity::read bad line " + line);
+                if (op == 1)
+                    add(u, v);
+                else if (op == 0)
+                    remove(u, v);
+                else
+                    throw std::runtime_error(
+                        "cDynamicConnectivity::read bad operation " + line);
+                count++;
+                if (batchSize > 0 && count % batchSize == 0)
+                    if (!visitor(count))
+                        return count;
+            }
+            if (batchSize <= 0 || count % batchSize)
+                visitor(count);
+            return count;
+        }
+
+        std::vector<path_t> componentGroups(
+            const std::vector<int> &label)
+        {
+            std::vector<path_t> ret;
+            for (int v = 0; v < label.size(); v++)
+            {
+                if (label[v] >= ret.size())
+                    ret.resize(label[v] + 1);
+                ret[label[v]].push_back(v);
+            }
+            return ret;
+        }
+    }
+}
@@ -0,0 +1,647 @@
+#include <algorithm>
+#include <cstdint>
+#include <queue>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// @brief mark the strongly connected component containing s, among vertices >= s
+        /// @param g
+        /// @param s vertex index
+        /// @param label strongly connected component of each vertex in the whole graph
+        /// @param[in/out] inComp set true for vertices in the component, previous component cleared first
+        /// @param[in/out] members vertices in the component, previous component on input
+        /// @param work
+        /// @return number of vertices in component
+        ///
+        /// The component is the intersection of the vertices s can reach
+        /// and the vertices that can reach s, both searches restricted to vertices >= s
+        /// in the same component of the whole graph
+
+        static int component_johnson(
+            const cGraph &g,
+            int s,
+            const std::vector<int> &label,
+            std::vector<bool> &inComp,
+            std::vector<int> &members,
+            cSearchWorkspace &work)
+        {
+            for (int v : members)
+                inComp[v] = false;
+            members.clear();
+
+            // vertices reachable from s
+            work.start(g.vertexCount());
+            auto &wait = work.waiting();
+            wait.push_back(s);
+            work.visit(s);
+            while (!wait.empty())
+            {
+                int v = wait.back();
+                wait.pop_back();
+                for (int w : g.adjacentOutRef(v))
+                {
+                    if (w < s || label[w] != label[s] || work.isVisited(w))
+                        continue;
+                    work.visit(w);
+                    wait.push_back(w);
+                }
+            }
+
+            // vertices that are reachable from s and can reach s
+            members.push_back(s);
+            inComp[s] = true;
+            wait.push_back(s);
+            while (!wait.empty())
+            {
+                int v = wait.back();
+                wait.pop_back();
+                for (int w : g.adjacentInRef(v))
+                {
+                    if (w < s || inComp[w] || !work.isVisited(w))
+                        continue;
+                    inComp[w] = true;
+                    members.push_back(w);
+                    wait.push_back(w);
+                }
+            }
+            return members.size();
+        }
+
+        /// @brief unblock a vertex, and the vertices waiting on it
+        /// @param u vertex index
+        /// @param blocked
+        /// @param B vertices to unblock when each vertex is unblocked
+
+        static void unblock_johnson(
+            int u,
+            std::vector<bool> &blocked,
+            std::vector<std::vector<int>> &B)
+        {
+            std::vector<int> wait;
+            wait.push_back(u);
+            blocked[u] = false;
+            while (!wait.empty())
+            {
+                int v = wait.back();
+                wait.pop_back();
+                for (int w : B[v])
+                {
+                    if (!blocked[w])
+                        continue;
+                    blocked[w] = false;
+                    wait.push_back(w);
+                }
+                B[v].clear();
+            }
+        }
+
+        path_t cCycleSet::canonical(const path_t &cycle) const
+        {
+            path_t ret(cycle);
+            if (ret.size() > 1 && ret.front() == ret.back())
+                ret.pop_back();
+            if (ret.empty())
+                return ret;
+
+            // start at lowest vertex index
+            std::rotate(
+                ret.begin(),
+                std::min_element(ret.begin(), ret.end()),
+                ret.end());
+
+            // go round in the direction of the lower second vertex
+            if (!myfDirected && ret.size() > 2 && ret[1] > ret.back())
+                std::reverse(ret.begin() + 1, ret.end());
+
+            return ret;
+        }
+
+        bool cCycleSet::insert(const path_t &cycle)
+        {
+            return mySet.insert(canonical(cycle)).second;
+        }
+
+        bool cCycleSet::contains(const path_t &cycle) const
+        {
+            return mySet.count(canonical(cycle)) > 0;
+        }
+
+        void elementaryCycles(
+            const cGraph &g,
+            std::function<bool(const path_t &cycle)> visitor,
+            int maxLength)
+        {
+            int n = g.vertexCount();
+            bool fDirected = g.isDirected();
+
+            std::vector<bool> inComp(n, false);
+            std::vector<int> members;
+            std::vector<bool> blocked(n, false);
+            std::vector<std::vector<int>> B(n);
+            cSearchWorkspace work;
+
+            // cycles never leave a strongly connected component
+            auto label = strongComponents(g);
+            std::vector<int> componentSize(n, 0);
+            for (int c : label)
+                componentSize[c]++;
+
+            // search frame: vertex, next adjacency index, true if a cycle was found beyond it
+            struct sFrame
+            {
+                int v;
+                int next;
+                bool found;
+            };
+            std::vector<sFrame> stack;
+            path_t path;
+
+            // find the cycles whose lowest vertex index is s
+            for (int s = 0; s < n; s++)
+            {
+                if (componentSize[label[s]] == 1 ||
+                    component_johnson(g, s, label, inComp, members, work) == 1)
+                {
+                    // single vertex, only a self loop can make a cycle
+                    if (fDirected && g.find(s, s) >= 0)
+                        if (!visitor(path_t(1, s)))
+                            return;
+                    continue;
+                }
+
+                for (int v : members)
+                {
+                    blocked[v] = false;
+                    B[v].clear();
+                }
+
+                stack.push_back({s, 0, false});
+                path.push_back(s);
+                blocked[s] = true;
+
+                while (!stack.empty())
+                {
+                    sFrame &f = stack.back();
+                    auto &adj = g.adjacentOutRef(f.v);
+
+                    if (f.next < adj.size())
+                    {
+                        int w = adj[f.next++];
+                        if (!inComp[w])
+                            continue;
+                        if (w == s)
+                        {
+                            f.found = true;
+
+                            // undirected graphs: no back and forth over one link,
+                            // and report each cycle in one direction only
+                            if (!fDirected)
+                                if (path.size() < 3 || path[1] > path.back())
+                                    continue;
+                            if (!visitor(path))
+                                return;
+                            continue;
+                        }
+                        if (blocked[w])
+                            continue;
+                        if (maxLength > 0 && path.size() >= maxLength)
+                        {
+                            // too long, the search was cut short so do not block
+                            f.found = true;
+                            continue;
+                        }
+                        blocked[w] = true;
+                        path.push_back(w);
+                        stack.push_back({w, 0, false});
+                        continue;
+                    }
+
+                    // all links from this vertex searched
+                    int v = f.v;
+                    bool found = f.found;
+                    if (found)
+                        unblock_johnson(v, blocked, B);
+                    else
+                    {
+                        // stay blocked until a vertex it links to is unblocked
+                        for (int w : adj)
+                        {
+                            if (!inComp[w])
+                                continue;
+                            if (std::find(B[w].begin(), B[w].end(), v) == B[w].end())
+                                B[w].push_back(v);
+                        }
+                    }
+                    stack.pop_back();
+                    path.pop_back();
+                    if (!stack.empty() && found)
+                        stack.back().found = true;
+                }
+            }
+        }
+
+        /// @brief undirected links numbered 0 to L-1, in the order of cGraph::edgeList
+        struct sLinks_cycles
+        {
+            // link index of each adjacency list entry
+            std::vector<std::vector<int>> vId;
+
+            // link cost
+            std::vector<double> vCost;
+
+            sLinks_cycles(
+                const cGraph &g,
+                const std::vector<double> &edgeWeight)
+                : vId(g.vertexCount())
+            {
+                if (g.isDirected())
+                    throw std::runtime_error(
+                        "cycle basis needs undirected graph");
+
+                for (int v = 0; v < g.vertexCount(); v++)
+                {
+                    auto &adj = g.adjacentOutRef(v);
+                    vId[v].resize(adj.size(), -1);
+                    for (int k = 0; k < adj.size(); k++)
+                    {
+                        int w = adj[k];
+                        if (v >= w)
+                            continue;
+                        vId[v][k] = vCost.size();
+                        if (edgeWeight.size())
+                            vCost.push_back(edgeWeight[g.find(v, w)]);
+                        else
+                            vCost.push_back(1);
+                    }
+                }
+                for (int v = 0; v < g.vertexCount(); v++)
+                {
+                    auto &adj = g.adjacentOutRef(v);
+                    for (int k = 0; k < adj.size(); k++)
+                    {
+                        int w = adj[k];
+                        if (v <= w)
+                            continue;
+                        auto &wadj = g.adjacentOutRef(w);
+                        vId[v][k] = vId[w][std::find(wadj.begin(), wadj.end(), v) - wadj.begin()];
+                    }
+                }
+            }
+            int count() const
+            {
+                return vCost.size();
+            }
+        };
+
+        /// @brief closed cycle around a link and two tree paths back to their common ancestor
+        /// @param pred tree parent of each vertex, -1 at root
+        /// @param depth tree depth of each vertex
+        /// @param u one end of link
+        /// @param w other end of link
+        /// @return u, tree path to common ancestor, tree path to w, u
+
+        static path_t treeCycle_cycles(
+            const std::vector<int> &pred,
+            const std::vector<int> &depth,
+            int u,
+            int w)
+        {
+            path_t up, down;
+            while (depth[u] > depth[w])
+            {
+                up.push_back(u);
+                u = pred[u];
+            }
+            while (depth[w] > depth[u])
+            {
+                down.push_back(w);
+                w = pred[w];
+            }
+            while (u != w)
+            {
+                up.push_back(u);
+                u = pred[u];
+                down.push_back(w);
+                w = pred[w];
+            }
+            up.push_back(u);
+            up.insert(up.end(), down.rbegin(), down.rend());
+            up.push_back(up[0]);
+            return up;
+        }
+
+        std::vector<path_t> cycleBasis(const cGraph &g)
+        {
+            std::vector<path_t> ret;
+            if (g.isDirected())
+                throw std::runtime_error(
+                    "cycleBasis: needs undirected graph");
+
+            int n = g.vertexCount();
+            std::vector<int> pred(n, -1);
+            std::vector<int> depth(n, -1);
+            std::vector<int> Q;
+
+            // loop over components
+            for (int root = 0; root < n; root++)
+            {
+                if (depth[root] >= 0)
+                    continue;
+
+                // breadth first spanning tree
+                depth[root] = 0;
+                Q.clear();
+                Q.push_back(root);
+                for (int front = 0; front < Q.size(); front++)
+                {
+                    int v = Q[front];
+                    for (int w : g.adjacentOutRef(v))
+                    {
+                        if (depth[w] >= 0)
+                            continue;
+                        depth[w] = depth[v] + 1;
+                        pred[w] = v;
+                        Q.push_back(w);
+                    }
+                }
+
+                // each link not in the tree closes one cycle
+                for (int v : Q)
+                    for (int w : g.adjacentOutRef(v))
+                    {
+                        if (v >= w || pred[w] == v || pred[v] == w)
+                            continue;
+                        ret.push_back(treeCycle_cycles(pred, depth, v, w));
+                    }
+            }
+            return ret;
+        }
+
+        std::vector<path_t> minimumCycleBasis(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight)
+        {
+            std::vector<path_t> ret;
+            if (g.isDirected())
+                throw std::runtime_error(
+                    "minimumCycleBasis: needs undirected graph");
+
+            int n = g.vertexCount();
+            sLinks_cycles links(g, edgeWeight);
+
+            // dimension of cycle space
+            int dimension = links.count() - n + components(g).size();
+            if (dimension <= 0)
+                return ret;
+
+            /* Horton candidates
+
+            For every vertex r and link (x,y), the shortest path r to x, the link, and the shortest path y to r
+            is a candidate when the two paths meet only at r.
+            A minimum basis can be chosen from these candidates, cheapest first.
+            */
+            struct sCandidate
+            {
+                double cost;
+                path_t cycle;
+            };
+            std::vector<sCandidate> vCandidate;
+            cCycleSet found(false);
+            cSearchWorkspace work;
+            std::vector<int> pred(n), depth(n);
+            std::vector<bool> onPath(n);
+            path_t up;
+
+            // dijsktra needs a cost for every link
+            std::vector<double> unitWeight;
+            const std::vector<double> *pWeight = &edgeWeight;
+            if (!edgeWeight.size())
+            {
+                for (int v = 0; v < n; v++)
+                    for (int w : g.adjacentOutRef(v))
+                    {
+                        int ei = g.find(v, w);
+                        if (ei >= (int)unitWeight.size())
+                            unitWeight.resize(ei + 1, 1);
+                    }
+                pWeight = &unitWeight;
+            }
+
+            for (int r = 0; r < n; r++)
+            {
+                // shortest path tree from r
+                dijsktra(g, *pWeight, r, -1, work);
+                for (int v = 0; v < n; v++)
+                {
+                    pred[v] = work.pred(v);
+                    depth[v] = -1;
+                }
+                depth[r] = 0;
+                for (int v = 0; v < n; v++)
+                {
+                    if (!work.isVisited(v))
+                        continue;
+
+                    // walk up to a vertex with known depth
+                    up.clear();
+                    int u = v;
+                    while (depth[u] < 0)
+                    {
+                        up.push_back(u);
+                        u = pred[u];
+                    }
+                    int d = depth[u];
+                    for (auto it = up.rbegin(); it != up.rend(); it++)
+                        depth[*it] = ++d;
+                }
+
+                for (int x = 0; x < n; x++)
+                {
+                    if (!work.isVisited(x))
+                        continue;
+                    auto &adj = g.adjacentOutRef(x);
+                    for (int k = 0; k < adj.size(); k++)
+                    {
+                        int y = adj[k];
+                        if (x >= y || pred[x] == y || pred[y] == x)
+                            continue;
+
+                        // paths must meet only at r
+                        for (int u = x; u != -1; u = pred[u])
+                            onPath[u] = true;
+                        bool fSimple = true;
+                        for (int u = y; u != r; u = pred[u])
+                            if (onPath[u])
+                            {
+                                fSimple = false;
+                                break;
+                            }
+                        for (int u = x; u != -1; u = pred[u])
+                            onPath[u] = false;
+                        if (!fSimple)
+                            continue;
+
+                        path_t cycle = treeCycle_cycles(pred, depth, x, y);
+                        if (!found.insert(cycle))
+                            continue;
+                        vCandidate.push_back({work.dist(x) + work.dist(y) + links.vCost[links.vId[x][k]],
+                                              cycle});
+                    }
+                }
+            }
+            std::stable_sort(
+                vCandidate.begin(), vCandidate.end(),
+                [](const sCandidate &a, const sCandidate &b)
+                {
+                    return a.cost < b.cost;
+                });
+
+            /* keep candidates that are independent of those already kept
+
+            Each cycle is a bit vector over the links, arithmetic modulo 2.
+            The kept vectors are stored reduced, each with a distinct lowest set bit.
+            */
+            int words = (links.count() + 63) / 64;
+            std::vector<std::vector<uint64_t>> vRow;
+            std::vector<int> pivotRow(links.count(), -1);
+            std::vector<uint64_t> bits(words);
+
+            for (auto &c : vCandidate)
+            {
+                std::fill(bits.begin(), bits.end(), 0);
+                for (int i = 0; i + 1 < c.cycle.size(); i++)
+                {
+                    int u = c.cycle[i];
+                    auto &adj = g.adjacentOutRef(u);
+                    int id = links.vId[u][std::find(adj.begin(), adj.end(), c.cycle[i + 1]) - adj.begin()];
+                    bits[id / 64] ^= (uint64_t)1 << (id % 64);
+                }
+
+                // reduce by kept vectors
+                int pivot = -1;
+                for (int wi = 0; wi < words; wi++)
+                {
+                    while (bits[wi])
+                    {
+                        int b = wi * 64 + __builtin_ctzll(bits[wi]);
+                        if (pivotRow[b] < 0)
+                        {
+                            pivot = b;
+                            break;
+                        }
+                        auto &row = vRow[pivotRow[b]];
+                        for (int k = wi; k < words; k++)
+                            bits[k] ^= row[k];
+                    }
+                    if (pivot >= 0)
+                        break;
+                }
+                if (pivot < 0)
+                    continue; // sum of cheaper cycles
+
+                pivotRow[pivot] = vRow.size();
+                vRow.push_back(bits);
+                ret.push_back(c.cycle);
+                if (ret.size() == dimension)
+                    break;
+            }
+            return ret;
+        }
+
+        int girth(const cGraph &g)
+        {
+            int n = g.vertexCount();
+            bool fDirected = g.isDirected();
+            int best = INT_MAX;
+            cSearchWorkspace work;
+
+            for (int r = 0; r < n; r++)
+            {
+                // breadth first search from r, distances in work
+                // stop when no shorter cycle through r is possible
+                work.start(n);
+                auto &Q = work.waiting();
+                work.dist(r, 0);
+                work.visit(r);
+                Q.push_back(r);
+                for (int front = 0; front < Q.size(); front++)
+                {
+                    int v = Q[front];
+                    int dv = work.dist(v);
+                    if (fDirected)
+                    {
+                        if (dv + 1 >= best)
+                            break;
+                    }
+                    else if (2 * dv + 1 >= best)
+                        break;
+
+                    for (int w : g.adjacentOutRef(v))
+                    {
+                        if (fDirected)
+                        {
+                            if (w == r)
+                            {
+                                best = std::min(best, dv + 1);
+                                continue;
+                            }
+                        }
+                        else if (w == work.pred(v))
+                            continue;
+
+                        if (!work.isVisited(w))
+                        {
+                            work.visit(w);
+                            work.dist(w, dv + 1);
+                            work.pred(w, v);
+                            Q.push_back(w);
+                        }
+                        else if (!fDirected)
+                        {
+                            // non tree link closes a cycle through or near r
+                            best = std::min(best, dv + (int)work.dist(w) + 1);
+                        }
+                    }
+                }
+            }
+            if (best == INT_MAX)
+                return 0;
+            return best;
+        }
+
+        std::vector<std::vector<int>>
+        dfs_cycle_finder(sGraphData &gd)
+        {
+            // store for found cycles, vertex indices in order reached.
+            std::vector<std::vector<int>> ret;
+
+            int startIndex = -1;
+            if (!gd.startName.empty())
+            {
+                startIndex = gd.g.find(gd.startName);
+                if (startIndex < 0)
+                    throw std::runtime_error(
+                        "dfs_cycle_finder bad start");
+            }
+
+            elementaryCycles(
+                gd.g,
+                [&](const path_t &cycle)
+                {
+                    if (startIndex >= 0 &&
+                        std::find(cycle.begin(), cycle.end(), startIndex) == cycle.end())
+                        return true;
+
+                    // close the cycle
+                    ret.push_back(cycle);
+                    ret.back().push_back(cycle[0]);
+                    return true;
+                });
+
+            return ret;
+        }
+    }
+}
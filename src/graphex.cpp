@@ -188,10 +188,17 @@ void s2s()
 
 void span()
 {
-    raven::graph::sGraphData gd;
-    gd.g = theGraph;
-    gd.startName = theGraph.userName(0);
-    raven::graph::spanningTree(gd);
+    std::vector<double> weight(2 * theGraph.edgeCount(), 1);
+    std::vector<int> forest;
+    {
+        raven::set::cRunWatch aWatcher("span kruskal");
+        forest = raven::graph::spanningTreeKruskal(theGraph, weight);
+    }
+    {
+        raven::set::cRunWatch aWatcher("span boruvka");
+        forest = raven::graph::spanningForestBoruvka(theGraph, weight);
+    }
+    std::cout << forest.size() << " forest links\n";
 }
 
 void paths()
@@ -220,6 +227,97 @@ void allPaths()
     allPaths( gd );
 }
 
+void bfs()
+{
+    int start = rand() % theGraph.vertexCount(); // random start vertex
+
+    {
+        raven::set::cRunWatch aWatcher("bfs topdown");
+        raven::graph::bfs(
+            theGraph,
+            start,
+            [](int v)
+            {
+                return true;
+            });
+    }
+
+    std::vector<int> pred;
+    long long inspected;
+    {
+        raven::set::cRunWatch aWatcher("bfs directionOptimizing");
+        inspected = raven::graph::bfsDirectionOptimizing(
+            theGraph,
+            {},
+            start, -1,
+            pred);
+    }
+    std::cout << "direction optimizing bfs inspected " << inspected
+              << " of " << theGraph.edgeCount() << " links\n";
+}
+
+void components()
+{
+    {
+        raven::set::cRunWatch aWatcher("components dfs");
+        raven::graph::components(theGraph);
+    }
+    std::vector<int> label;
+    {
+        raven::set::cRunWatch aWatcher("components union find");
+        label = raven::graph::componentLabels(theGraph);
+    }
+    std::cout << raven::graph::componentGroups(label).size() << " components\n";
+}
+
+void cuts()
+{
+    raven::graph::cGraph g;
+    for (auto &l : theGraph.edgeList())
+        g.add(l.first, l.second);
+
+    raven::graph::cTarjan T;
+    {
+        raven::set::cRunWatch aWatcher("cuts sequential");
+        T.search(g);
+    }
+    std::vector<int> vAP;
+    std::vector<std::pair<int, int>> vBridge;
+    {
+        raven::set::cRunWatch aWatcher("cuts parallel");
+        raven::graph::cutsParallel(g, vAP, vBridge);
+    }
+    std::cout << vAP.size() << " articulation points "
+              << vBridge.size() << " bridges\n";
+}
+
+void dynamic(const std::vector<std::string> &q)
+{
+    if (q.size() < 2)
+        return;
+    std::ifstream ifs(q[1]);
+    if (!ifs.is_open())
+    {
+        std::cout << "Cannot open " + q[1] << "\n";
+        return;
+    }
+    int batch = 10000;
+    if (q.size() > 2)
+        batch = atoi(q[2].c_str());
+
+    raven::set::cRunWatch aWatcher("dynamic");
+    raven::graph::cDynamicConnectivity dc(0, true);
+    dc.read(
+        ifs, batch,
+        [&](int ops)
+        {
+            std::cout << ops << " operations "
+                      << dc.vertexCount() << " vertices "
+                      << dc.componentCount() << " components\n";
+            return true;
+        });
+}
+
 void ancestor_recurse(
     int v,
     int depth,
@@ -281,13 +379,17 @@ void help()
                  "add random n :  add n random links to graph\n"
                  "read filepath : input graph links from file\n"
                  "display :       display links\n"
+                 "dynamic filepath n : stream link additions ( 1 u v ) and removals ( 0 u v ), count components every n\n"
                  "paths :         find all paths from random vertex to all others ( Dijkstra )\n"
                  "allpaths :      find all paths between two random vertices ( Dijkstra )\n"
+                 "bfs :           breadth first search from random vertex, top down and direction optimizing\n"
+                 "components :    find connected components, depth first and union find\n"
+                 "cuts :          find articulation points and bridges, links undirected\n"
                  "cycles :        find cycles in graph\n"
                  "s2s :           find source to sink connections\n"
                  "gen n :         generate random graph with n vertices\n"
                  "euler n :       find euler path\n"
-                 "span :          find spanning tree\n"
+                 "span :          find minimum spanning forest\n"
                  "help :          this help display\n\n";
 }
 
@@ -316,6 +418,12 @@ main()
                 read(q);
             else if (q[0] == "ancestor")
                 ancestor();
+            else if (q[0] == "components")
+                components();
+            else if (q[0] == "dynamic")
+                dynamic(q);
+            else if (q[0] == "cuts")
+                cuts();
             else if (q[0] == "cycles")
                 cycles();
             else if (q[0] == "s2s")
@@ -330,6 +438,8 @@ main()
                 paths();
             else if (q[0] == "allpaths")
                 allPaths();
+            else if (q[0] == "bfs")
+                bfs();
             else if (q[0] == "cover")
                 vertexCover(theGraph);
             else
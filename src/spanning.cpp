@@ -0,0 +1,314 @@
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <numeric>
+#include <queue>
+#include <thread>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        std::vector<int> spanningTreePrim(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int start)
+        {
+            std::vector<int> ret;
+            int n = g.vertexCount();
+            if (0 > start || start >= n)
+                throw std::runtime_error(
+                    "spanningTreePrim bad start");
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "spanningTreePrim bad edge weights");
+
+            std::vector<bool> visited(n, false);
+
+            /* links leaving the tree, cheapest at top
+
+            ties go to the lowest tree vertex index, then the first in its adjacency list,
+            the same choice as a scan of every tree vertex's links would make
+            */
+            struct sLink
+            {
+                double cost;
+                int v;  // tree vertex
+                int k;  // index in v's adjacency list
+                int w;  // vertex outside tree when link was found
+                int ei; // edge index
+                bool operator>(const sLink &other) const
+                {
+                    if (cost != other.cost)
+                        return cost > other.cost;
+                    if (v != other.v)
+                        return v > other.v;
+                    return k > other.k;
+                }
+            };
+            std::priority_queue<sLink, std::vector<sLink>, std::greater<sLink>> Q;
+
+            auto addVertex = [&](int v)
+            {
+                visited[v] = true;
+                auto &adj = g.adjacentOutRef(v);
+                for (int k = 0; k < adj.size(); k++)
+                {
+                    int w = adj[k];
+                    if (visited[w])
+                        continue;
+                    int ei = g.find(v, w);
+                    Q.push({edgeWeight[ei], v, k, w, ei});
+                }
+            };
+
+            addVertex(start);
+            while (!Q.empty())
+            {
+                sLink l = Q.top();
+                Q.pop();
+                if (visited[l.w])
+                    continue;
+                ret.push_back(l.ei);
+                addVertex(l.w);
+            }
+            return ret;
+        }
+
+        std::vector<std::pair<int, int>> spanningTreePrim(
+            const cEuclideanGraph &g,
+            int start)
+        {
+            std::vector<std::pair<int, int>> ret;
+            int n = g.vertexCount();
+            if (!n)
+                return ret;
+            if (0 > start || start >= n)
+                throw std::runtime_error(
+                    "spanningTreePrim bad start");
+
+            // cheapest link from the tree to each vertex outside it, and the tree vertex it comes from
+            std::vector<double> key(n, std::numeric_limits<double>::infinity());
+            std::vector<int> from(n, -1);
+            std::vector<bool> inTree(n, false);
+            std::vector<double> weight;
+
+            int v = start;
+            inTree[v] = true;
+            for (int added = 1; added < n; added++)
+            {
+                g.edgeWeights(v, weight);
+                int next = -1;
+                for (int w = 0; w < n; w++)
+                {
+                    if (inTree[w])
+                        continue;
+                    if (weight[w] < key[w])
+                    {
+                        key[w] = weight[w];
+                        from[w] = v;
+                    }
+                    if (next < 0 || key[w] < key[next])
+                        next = w;
+                }
+                ret.push_back(std::make_pair(from[next], next));
+                inTree[next] = true;
+                v = next;
+            }
+            return ret;
+        }
+
+        std::vector<int> spanningTreeKruskal(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight)
+        {
+            std::vector<int> ret;
+            int n = g.vertexCount();
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "spanningTreeKruskal bad edge weights");
+
+            // every link once
+            std::vector<int> vLink;
+            for (int v = 0; v < n; v++)
+                for (int w : g.adjacentOutRef(v))
+                    if (g.isDirected() || v < w)
+                        vLink.push_back(g.find(v, w));
+
+            // cheapest first, ties in edge index order
+            std::sort(
+                vLink.begin(), vLink.end(),
+                [&](int a, int b)
+                {
+                    if (edgeWeight[a] != edgeWeight[b])
+                        return edgeWeight[a] < edgeWeight[b];
+                    return a < b;
+                });
+
+            // union find
+            std::vector<int> parent(n);
+            std::iota(parent.begin(), parent.end(), 0);
+            auto root = [&](int v)
+            {
+                while (parent[v] != v)
+                {
+                    parent[v] = parent[parent[v]];
+                    v = parent[v];
+                }
+                return v;
+            };
+
+            // keep links joining two trees
+            for (int ei : vLink)
+            {
+                int a = root(g.src(ei));
+                int b = root(g.dest(ei));
+                if (a == b)
+                    continue;
+                parent[std::max(a, b)] = std::min(a, b);
+                ret.push_back(ei);
+                if (ret.size() == n - 1)
+                    break;
+            }
+            return ret;
+        }
+
+        std::vector<int> spanningForestBoruvka(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            int threads)
+        {
+            std::vector<int> ret;
+            int n = g.vertexCount();
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "spanningForestBoruvka bad edge weights");
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 0)
+                threads = 1;
+
+            // every link once
+            struct sLink
+            {
+                int u;
+                int v;
+                int ei;
+                double cost;
+            };
+            std::vector<sLink> vLink;
+            for (int v = 0; v < n; v++)
+                for (int w : g.adjacentOutRef(v))
+                    if (g.isDirected() || v < w)
+                    {
+                        int ei = g.find(v, w);
+                        vLink.push_back({v, w, ei, edgeWeight[ei]});
+                    }
+
+            // link a is cheaper than link b, ties to the lower index so there is never a cycle of equal links
+            auto cheaper = [&](int a, int b)
+            {
+                if (vLink[a].cost != vLink[b].cost)
+                    return vLink[a].cost < vLink[b].cost;
+                return a < b;
+            };
+
+            // component of each vertex, flattened so every vertex points at its component root
+            std::vector<int> comp(n);
+            std::iota(comp.begin(), comp.end(), 0);
+
+            // cheapest link leaving each component, -1 for none
+            std::vector<std::atomic<int>> best(n);
+
+            // links that still join two components
+            std::vector<int> live(vLink.size());
+            std::iota(live.begin(), live.end(), 0);
+
+            while (live.size())
+            {
+                for (auto &b : best)
+                    b = -1;
+
+                // each thread offers its links to the components at their ends
+                share(
+                    live.size(), threads,
+                    [&](int first, int last, int t)
+                    {
+                        for (int k = first; k < last; k++)
+                        {
+                            int l = live[k];
+                            for (int c : {comp[vLink[l].u], comp[vLink[l].v]})
+                            {
+                                int cur = best[c].load();
+                                while ((cur == -1 || cheaper(l, cur)) &&
+                                       !best[c].compare_exchange_weak(cur, l))
+                                    ;
+                            }
+                        }
+                    });
+
+                // join each component to its cheapest neighbour
+                bool fMerged = false;
+                std::vector<int> parent(comp);
+                auto root = [&](int v)
+                {
+                    while (parent[v] != v)
+                    {
+                        parent[v] = parent[parent[v]];
+                        v = parent[v];
+                    }
+                    return v;
+                };
+                for (int c = 0; c < n; c++)
+                {
+                    int l = best[c].load();
+                    if (l < 0)
+                        continue;
+                    int a = root(vLink[l].u);
+                    int b = root(vLink[l].v);
+                    if (a == b)
+                        continue; // chosen from both ends
+                    parent[std::max(a, b)] = std::min(a, b);
+                    ret.push_back(vLink[l].ei);
+                    fMerged = true;
+                }
+                if (!fMerged)
+                    break;
+
+                // flatten
+                share(
+                    n, threads,
+                    [&](int first, int last, int t)
+                    {
+                        for (int v = first; v < last; v++)
+                        {
+                            int r = v;
+                            while (parent[r] != r)
+                                r = parent[r];
+                            comp[v] = r;
+                        }
+                    });
+
+                // drop links inside a component
+                std::vector<int> next;
+                for (int l : live)
+                    if (comp[vLink[l].u] != comp[vLink[l].v])
+                        next.push_back(l);
+                live.swap(next);
+            }
+            return ret;
+        }
+
+        cGraph spanningGraph(
+            const cGraph &g,
+            const std::vector<int> &edges)
+        {
+            cGraph ret(g);
+            ret.removeLinks();
+            for (int ei : edges)
+                ret.add(g.src(ei), g.dest(ei));
+            return ret;
+        }
+    }
+}
@@ -0,0 +1,229 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+#include <queue>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        cSpatialIndex::cSpatialIndex(
+            const std::vector<double> &x,
+            const std::vector<double> &y)
+            : myX(x),
+              myY(y)
+        {
+            if (x.size() != y.size())
+                throw std::runtime_error(
+                    "cSpatialIndex bad locations");
+            build();
+        }
+
+        cSpatialIndex::cSpatialIndex(const cGraph &g)
+        {
+            int n = g.vertexCount();
+            myX.resize(n);
+            myY.resize(n);
+            for (int v = 0; v < n; v++)
+            {
+                myX[v] = atof(g.rVertexAttr(v, 0).c_str());
+                myY[v] = atof(g.rVertexAttr(v, 1).c_str());
+            }
+            build();
+        }
+
+        void cSpatialIndex::build()
+        {
+            int n = myX.size();
+            myOrder.resize(n);
+            std::iota(myOrder.begin(), myOrder.end(), 0);
+            mySplitY.assign(n, false);
+
+            // ranges still to split
+            std::vector<std::pair<int, int>> wait{{0, n}};
+            while (!wait.empty())
+            {
+                int lo = wait.back().first;
+                int hi = wait.back().second;
+                wait.pop_back();
+                if (hi - lo <= leafSize)
+                    continue;
+
+                // split across the wider spread
+                double x0 = myX[myOrder[lo]], x1 = x0;
+                double y0 = myY[myOrder[lo]], y1 = y0;
+                for (int k = lo + 1; k < hi; k++)
+                {
+                    int v = myOrder[k];
+                    x0 = std::min(x0, myX[v]);
+                    x1 = std::max(x1, myX[v]);
+                    y0 = std::min(y0, myY[v]);
+                    y1 = std::max(y1, myY[v]);
+                }
+                bool fY = (y1 - y0) > (x1 - x0);
+                const auto &key = fY ? myY : myX;
+
+                int mid = (lo + hi) / 2;
+                std::nth_element(
+                    myOrder.begin() + lo,
+                    myOrder.begin() + mid,
+                    myOrder.begin() + hi,
+                    [&](int a, int b)
+                    {
+                        return key[a] < key[b];
+                    });
+                mySplitY[mid] = fY;
+                wait.push_back(std::make_pair(lo, mid));
+                wait.push_back(std::make_pair(mid + 1, hi));
+            }
+        }
+
+        std::vector<int> cSpatialIndex::nearest(int v, int k) const
+        {
+            return search(myX[v], myY[v], k, v);
+        }
+
+        std::vector<int> cSpatialIndex::nearest(double x, double y, int k) const
+        {
+            return search(x, y, k, -1);
+        }
+
+        std::vector<int> cSpatialIndex::search(
+            double x, double y,
+            int k,
+            int exclude) const
+        {
+            std::vector<int> ret;
+            if (k <= 0)
+                return ret;
+
+            // furthest of the nearest found at top, ties to the higher index
+            std::priority_queue<std::pair<double, int>> Q;
+
+            std::function<void(int, int)> visit = [&](int lo, int hi)
+            {
+                if (hi - lo <= leafSize)
+                {
+                    for (int p = lo; p < hi; p++)
+                    {
+                        int w = myOrder[p];
+                        if (w == exclude)
+                            continue;
+                        double dx = myX[w] - x;
+                        double dy = myY[w] - y;
+                        auto c = std::make_pair(dx * dx + dy * dy, w);
+                        if ((int)Q.size() < k)
+                            Q.push(c);
+                        else if (c < Q.top())
+                        {
+                            Q.pop();
+                            Q.push(c);
+                        }
+                    }
+                    return;
+                }
+                int mid = (lo + hi) / 2;
+                int m = myOrder[mid];
+                double diff = mySplitY[mid] ? y - myY[m] : x - myX[m];
+
+                // the median, then the side holding the point, then the other side if it could be nearer
+                visit(mid, mid + 1);
+                if (diff < 0)
+                    visit(lo, mid);
+                else
+                    visit(mid + 1, hi);
+                if ((int)Q.size() < k || diff * diff <= Q.top().first)
+                {
+                    if (diff < 0)
+                        visit(mid + 1, hi);
+                    else
+                        visit(lo, mid);
+                }
+            };
+            visit(0, myOrder.size());
+
+            while (!Q.empty())
+            {
+                ret.push_back(Q.top().second);
+                Q.pop();
+            }
+            std::reverse(ret.begin(), ret.end());
+            return ret;
+        }
+
+        std::vector<int> cSpatialIndex::within(double x, double y, double radius) const
+        {
+            std::vector<int> ret;
+            double r2 = radius * radius;
+            std::function<void(int, int)> visit = [&](int lo, int hi)
+            {
+                if (hi - lo <= leafSize)
+                {
+                    for (int p = lo; p < hi; p++)
+                    {
+                        int w = myOrder[p];
+                        double dx = myX[w] - x;
+                        double dy = myY[w] - y;
+                        if (dx * dx + dy * dy <= r2)
+                            ret.push_back(w);
+                    }
+                    return;
+                }
+                int mid = (lo + hi) / 2;
+                int m = myOrder[mid];
+                double diff = mySplitY[mid] ? y - myY[m] : x - myX[m];
+
+                // the median, then each side that reaches within the radius
+                visit(mid, mid + 1);
+                if (diff >= -radius)
+                    visit(mid + 1, hi);
+                if (diff <= radius)
+                    visit(lo, mid);
+            };
+            visit(0, myOrder.size());
+            std::sort(ret.begin(), ret.end());
+            return ret;
+        }
+
+        cEuclideanGraph::cEuclideanGraph(
+            const std::vector<double> &x,
+            const std::vector<double> &y)
+            : myX(x),
+              myY(y)
+        {
+            if (x.size() != y.size())
+                throw std::runtime_error(
+                    "cEuclideanGraph bad locations");
+        }
+
+        cEuclideanGraph::cEuclideanGraph(const cGraph &g)
+        {
+            int n = g.vertexCount();
+            myX.resize(n);
+            myY.resize(n);
+            for (int v = 0; v < n; v++)
+            {
+                myX[v] = atof(g.rVertexAttr(v, 0).c_str());
+                myY[v] = atof(g.rVertexAttr(v, 1).c_str());
+            }
+        }
+
+        void cEuclideanGraph::edgeWeights(int u, std::vector<double> &weight) const
+        {
+            int n = myX.size();
+            weight.resize(n);
+            const double ux = myX[u];
+            const double uy = myY[u];
+            const double *px = myX.data();
+            const double *py = myY.data();
+            double *pw = weight.data();
+            for (int v = 0; v < n; v++)
+            {
+                double dx = px[v] - ux;
+                double dy = py[v] - uy;
+                pw[v] = std::sqrt(dx * dx + dy * dy);
+            }
+        }
+    }
+}
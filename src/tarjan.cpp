@@ -1,4 +1,6 @@
+#include <algorithm>
 #include <iostream>
+#include <thread>
 #include <vector>
 #include "GraphTheory.h"
 
@@ -9,99 +11,342 @@ namespace raven
 
         std::vector<std::string> cTarjan::ArticulationPoints(sGraphData &gd)
         {
-            if (gd.g.isDirected())
+            search(gd.g);
+
+            std::vector<std::string> ret;
+            for (int p : vAP)
+                ret.push_back(gd.g.userName(p));
+
+            return ret;
+        }
+
+        void cTarjan::search(const cGraph &g)
+        {
+            if (g.isDirected())
                 throw std::runtime_error(
                     "Tarjan works only for undirected graphs");
 
-            visited.clear();
-            visited.resize(gd.g.vertexCount(), false);
+            int n = g.vertexCount();
             disc.clear();
-            disc.resize(gd.g.vertexCount(), 0);
+            disc.resize(n, 0);
             low.clear();
-            low.resize(gd.g.vertexCount(), 0);
-            sAP.clear();
+            low.resize(n, 0);
+            vAP.clear();
+            vBridge.clear();
+            vBiconnected.clear();
 
-            std::vector<std::string> vAP;
-            int time = 0, parent = -1;
+            std::vector<bool> isAP(n, false);
+
+            // depth first search frame
+            struct sFrame
+            {
+                int v;       // vertex
+                int parent;  // vertex reached from, -1 for root
+                int next;    // next adjacency index to search
+                bool fSkip;  // true when the link back to parent has been skipped
+            };
+            std::vector<sFrame> stack;
+
+            // links searched, not yet assigned to a biconnected component
+            std::vector<std::pair<int, int>> vLink;
+
+            int time = 0;
 
             // Adding this loop so that the
             // code works even if we are given
             // disconnected graph
-            for (int u = 0; u < gd.g.vertexCount(); u++)
-                if (!visited[u])
+            for (int root = 0; root < n; root++)
+            {
+                if (disc[root])
+                    continue;
+
+                // Count of children in DFS Tree
+                int children = 0;
+
+                disc[root] = low[root] = ++time;
+                stack.push_back({root, -1, 0, false});
+
+                while (!stack.empty())
                 {
-                    gd.startName = gd.g.userName(u);
-                    APRecurse(
-                        gd,
-                        time, parent);
+                    sFrame &f = stack.back();
+                    int u = f.v;
+                    auto &adj = g.adjacentOutRef(u);
+
+                    if (f.next < adj.size())
+                    {
+                        int v = adj[f.next++];
+                        if (v == f.parent && !f.fSkip)
+                        {
+                            // the tree link back up is not a cycle
+                            f.fSkip = true;
+                            continue;
+                        }
+                        if (!disc[v])
+                        {
+                            // If v is not visited yet, then make it a child of u
+                            // in DFS tree and search it
+                            if (u == root)
+                                children++;
+                            vLink.push_back(std::make_pair(u, v));
+                            disc[v] = low[v] = ++time;
+                            stack.push_back({v, u, 0, false});
+                        }
+                        else if (disc[v] < disc[u])
+                        {
+                            // link back to an ancestor
+                            low[u] = std::min(low[u], disc[v]);
+                            vLink.push_back(std::make_pair(u, v));
+                        }
+                        continue;
+                    }
+
+                    // subtree rooted at u has been searched
+                    int p = f.parent;
+                    stack.pop_back();
+                    if (p < 0)
+                        continue;
+
+                    // Check if the subtree rooted with u has
+                    // a connection to one of the ancestors of p
+                    low[p] = std::min(low[p], low[u]);
+
+                    if (low[u] >= disc[p])
+                    {
+                        // If p is not root and low value of one of
+                        // its child is more than discovery value of p.
+                        if (p != root)
+                            isAP[p] = true;
+
+                        // the links searched since p to u form a biconnected component
+                        std::vector<int> component;
+                        while (true)
+                        {
+                            auto l = vLink.back();
+                            vLink.pop_back();
+                            component.push_back(l.first);
+                            component.push_back(l.second);
+                            if (l.first == p && l.second == u)
+                                break;
+                        }
+                        std::sort(component.begin(), component.end());
+                        component.erase(
+                            std::unique(component.begin(), component.end()),
+                            component.end());
+                        vBiconnected.push_back(component);
+                    }
+
+                    // no other way from u's subtree to p or above
+                    if (low[u] > disc[p])
+                        vBridge.push_back(std::make_pair(p, u));
                 }
 
-            for (int p : sAP)
-                vAP.push_back(gd.g.userName(p));
+                // If root of DFS tree has two or more children.
+                if (children > 1)
+                    isAP[root] = true;
+            }
 
-            return vAP;
+            for (int v = 0; v < n; v++)
+                if (isAP[v])
+                    vAP.push_back(v);
         }
 
-        // find articulation points in an undirected graph
-
-        // A recursive function that find articulation
-        // points using DFS traversal
-        // adj[] --> Adjacency List representation of the graph
-        // u --> The vertex to be visited next
-        // visited[] --> keeps track of visited vertices
-        // disc[] --> Stores discovery times of visited vertices
-        // low[] -- >> earliest visited vertex (the vertex with minimum
-        // discovery time) that can be reached from subtree
-        // rooted with current vertex
-        // parent --> Stores the parent vertex in DFS tree
-        // sAP[] --> Stores articulation points
-        void cTarjan::APRecurse(
-            sGraphData &gd,
-            int &time, int parent)
+        void cutsParallel(
+            const cGraph &g,
+            std::vector<int> &articulationPoints,
+            std::vector<std::pair<int, int>> &bridges,
+            int threads)
         {
-            int u = gd.g.find(gd.startName);
+            if (g.isDirected())
+                throw std::runtime_error(
+                    "cutsParallel works only for undirected graphs");
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 0)
+                threads = 1;
 
-            // Count of children in DFS Tree
-            int children = 0;
+            int n = g.vertexCount();
+            articulationPoints.clear();
+            bridges.clear();
 
-            // Mark the current node as visited
-            visited[u] = true;
+            // breadth first spanning forest, vertices stored in search order
+            std::vector<int> parent(n, -2);
+            std::vector<int> order;
+            order.reserve(n);
+            std::vector<int> depth(n);
+            for (int root = 0; root < n; root++)
+            {
+                if (parent[root] != -2)
+                    continue;
+                parent[root] = -1;
+                depth[root] = 0;
+                int front = order.size();
+                order.push_back(root);
+                for (; front < order.size(); front++)
+                {
+                    int v = order[front];
+                    for (int w : g.adjacentOutRef(v))
+                    {
+                        if (parent[w] != -2)
+                            continue;
+                        parent[w] = v;
+                        depth[w] = depth[v] + 1;
+                        order.push_back(w);
+                    }
+                }
+            }
 
-            // Initialize discovery time and low value
-            disc[u] = low[u] = ++time;
+            // tree children of each vertex
+            std::vector<std::vector<int>> children(n);
+            for (int v : order)
+                if (parent[v] >= 0)
+                    children[parent[v]].push_back(v);
+
+            // subtree sizes, leaves first
+            std::vector<int> size(n, 1);
+            for (int k = n - 1; k >= 0; k--)
+            {
+                int v = order[k];
+                if (parent[v] >= 0)
+                    size[parent[v]] += size[v];
+            }
 
-            // Go through all vertices adjacent to this
-            for (auto v : gd.g.adjacentOut(u))
+            // preorder numbers, a subtree is numbered pre[v] to pre[v] + size[v] - 1
+            std::vector<int> pre(n);
             {
-                // If v is not visited yet, then make it a child of u
-                // in DFS tree and recur for it
-                if (!visited[v])
+                int next = 0;
+                std::vector<int> wait;
+                for (int root : order)
                 {
-                    children++;
-                    sGraphData gd2;
-                    gd2 = gd;
-                    gd2.startName = gd.g.userName(v);
-                    APRecurse(
-                        gd2, time, u);
-
-                    // Check if the subtree rooted with v has
-                    // a connection to one of the ancestors of u
-                    low[u] = std::min(low[u], low[v]);
-
-                    // If u is not root and low value of one of
-                    // its child is more than discovery value of u.
-                    if (parent != -1 && low[v] >= disc[u])
-                        sAP.insert(u);
+                    if (parent[root] != -1)
+                        continue;
+                    wait.push_back(root);
+                    while (!wait.empty())
+                    {
+                        int v = wait.back();
+                        wait.pop_back();
+                        pre[v] = next++;
+                        for (auto it = children[v].rbegin(); it != children[v].rend(); it++)
+                            wait.push_back(*it);
+                    }
                 }
+            }
+
+            auto isTree = [&](int v, int w)
+            {
+                return parent[w] == v || parent[v] == w;
+            };
+
+            // lowest and highest preorder reached from each vertex by itself or a non tree link
+            std::vector<int> low(n), high(n);
+            share(
+                n, threads,
+                [&](int first, int last, int t)
+                {
+                    for (int v = first; v < last; v++)
+                    {
+                        low[v] = high[v] = pre[v];
+                        for (int w : g.adjacentOutRef(v))
+                        {
+                            if (isTree(v, w))
+                                continue;
+                            low[v] = std::min(low[v], pre[w]);
+                            high[v] = std::max(high[v], pre[w]);
+                        }
+                    }
+                });
 
-                // Update low value of u for parent function calls.
-                else if (v != parent)
-                    low[u] = std::min(low[u], disc[v]);
+            // extend to subtrees, deepest level first, each level shared between the threads
+            std::vector<std::vector<int>> vByDepth;
+            for (int v : order)
+            {
+                if (depth[v] >= vByDepth.size())
+                    vByDepth.resize(depth[v] + 1);
+                vByDepth[depth[v]].push_back(v);
+            }
+            for (int d = (int)vByDepth.size() - 1; d >= 0; d--)
+            {
+                auto &level = vByDepth[d];
+                share(
+                    level.size(), threads,
+                    [&](int first, int last, int t)
+                    {
+                        for (int k = first; k < last; k++)
+                        {
+                            int v = level[k];
+                            for (int c : children[v])
+                            {
+                                low[v] = std::min(low[v], low[c]);
+                                high[v] = std::max(high[v], high[c]);
+                            }
+                        }
+                    });
             }
 
-            // If u is root of DFS tree and has two or more children.
-            if (parent == -1 && children > 1)
-                sAP.insert(u);
+            // true if no non tree link leaves the subtree of v
+            auto isolated = [&](int v, int u)
+            {
+                return low[v] >= pre[u] && high[v] < pre[u] + size[u];
+            };
+
+            /* auxiliary graph, a vertex for each tree link, named by its child vertex
+
+            Tree links in the same biconnected component are joined when
+            - a non tree link joins their subtrees, neither an ancestor of the other
+            - a parent link and a child link, if the child's subtree reaches outside the parent's subtree
+            */
+            std::vector<std::vector<std::pair<int, int>>> vLocalLinks(threads);
+            share(
+                n, threads,
+                [&](int first, int last, int t)
+                {
+                    auto &links = vLocalLinks[t];
+                    for (int v = first; v < last; v++)
+                    {
+                        for (int w : g.adjacentOutRef(v))
+                        {
+                            if (v > w || isTree(v, w))
+                                continue;
+                            if (pre[v] + size[v] <= pre[w] || pre[w] + size[w] <= pre[v])
+                                links.push_back(std::make_pair(v, w));
+                        }
+                        int u = parent[v];
+                        if (u >= 0 && parent[u] >= 0 && !isolated(v, u))
+                            links.push_back(std::make_pair(u, v));
+                    }
+                });
+            std::vector<std::pair<int, int>> vAux;
+            for (auto &links : vLocalLinks)
+                vAux.insert(vAux.end(), links.begin(), links.end());
+            auto label = componentLabels(n, vAux, threads);
+
+            // a vertex is an articulation point if its tree links are in more than one component
+            std::vector<char> isAP(n, 0);
+            share(
+                n, threads,
+                [&](int first, int last, int t)
+                {
+                    for (int v = first; v < last; v++)
+                    {
+                        auto &vc = children[v];
+                        if (!vc.size())
+                            continue;
+                        int component = (parent[v] >= 0) ? label[v] : label[vc[0]];
+                        for (int c : vc)
+                            if (label[c] != component)
+                            {
+                                isAP[v] = 1;
+                                break;
+                            }
+                    }
+                });
+            for (int v = 0; v < n; v++)
+                if (isAP[v])
+                    articulationPoints.push_back(v);
+
+            // a tree link is a bridge if no non tree link crosses it
+            for (int v : order)
+                if (parent[v] >= 0 && isolated(v, v))
+                    bridges.push_back(std::make_pair(parent[v], v));
         }
 
     }
@@ -1,5 +1,9 @@
 #include <string>
 #include <iostream>
+#include <sstream>
+#include <cmath>
+#include <chrono>
+#include <random>
 #include "cutest.h"
 #include "GraphTheory.h"
 #include "cGrid2D.h"
@@ -185,6 +189,111 @@ TEST(bfs)
     CHECK_EQUAL(2, path.size());
 }
 
+TEST(bfsDirectionOptimizing)
+{
+    // random low diameter graph
+    raven::graph::sGraphData gd;
+    srand(1);
+    for (int k = 0; k < 2000; k++)
+        gd.g.add(rand() % 500, rand() % 500);
+    gd.edgeWeight.resize(2 * gd.g.edgeCount(), 1);
+    gd.startName = gd.g.userName(0);
+
+    for (int dest = 1; dest < 500; dest += 37)
+    {
+        gd.endName = gd.g.userName(dest);
+        auto td = bfsPath(gd);
+        auto dop = bfsPath(gd, raven::graph::bfs_engine::directionOptimizing);
+        CHECK_EQUAL(td.size(), dop.size());
+        if (dop.size())
+        {
+            CHECK_EQUAL(0, dop.front());
+            CHECK_EQUAL(dest, dop.back());
+        }
+    }
+
+    int tdCount = 0;
+    bfs(gd.g, 0,
+        [&](int v)
+        {
+            tdCount++;
+            return true;
+        });
+    std::vector<int> pred;
+    int doCount = 0;
+    long long inspected = bfsDirectionOptimizing(
+        gd.g, {}, 0, -1, pred,
+        [&](int v)
+        {
+            doCount++;
+            return true;
+        });
+    CHECK(doCount > 1);
+    CHECK_EQUAL(tdCount, doCount);
+    CHECK(inspected < 2 * 2 * 2000);
+    CHECK_EQUAL(doCount - 1, std::count_if(
+        pred.begin(), pred.end(),
+        [](int p)
+        { return p >= 0; }));
+}
+
+TEST(bfsParallel)
+{
+    raven::graph::sGraphData gd;
+    srand(2);
+    for (int k = 0; k < 20000; k++)
+        gd.g.add(rand() % 5000, rand() % 5000);
+    gd.edgeWeight.resize(2 * gd.g.edgeCount(), 1);
+    gd.startName = gd.g.userName(0);
+
+    // same visit order and predecessors as sequential search
+    std::vector<int> seqOrder, parOrder, pred;
+    bfs(gd.g, 0,
+        [&](int v)
+        {
+            seqOrder.push_back(v);
+            return true;
+        });
+    bfsParallel(
+        gd.g, {}, 0, -1, pred,
+        [&](int v)
+        {
+            parOrder.push_back(v);
+            return true;
+        },
+        4);
+    CHECK(seqOrder == parOrder);
+
+    // a sequential search reaches each vertex from the first vertex in the visit order linked to it
+    std::vector<int> seqPred(gd.g.vertexCount(), -1);
+    std::vector<bool> reached(gd.g.vertexCount(), false);
+    reached[0] = true;
+    for (int v : seqOrder)
+        for (int w : gd.g.adjacentOutRef(v))
+            if (!reached[w])
+            {
+                reached[w] = true;
+                seqPred[w] = v;
+            }
+    CHECK(seqPred == pred);
+
+    for (int dest = 1; dest < 5000; dest += 499)
+    {
+        gd.endName = gd.g.userName(dest);
+        auto seq = bfsPath(gd);
+        auto par = bfsPath(gd, raven::graph::bfs_engine::parallel);
+        CHECK(seq == par);
+
+        bfsParallel(
+            gd.g, gd.edgeWeight, 0, dest, pred,
+            nullptr, 4);
+        std::vector<int> par4;
+        for (int v = dest; v != -1; v = pred[v])
+            par4.insert(par4.begin(), v);
+        CHECK(seq == par4);
+    }
+}
+
 TEST(tarjan_gg3)
 {
     raven::graph::sGraphData gd;
@@ -245,6 +354,77 @@ TEST(tarjan_gg2)
     CHECK_EQUAL("2", vAP[1]);
 }
 
+TEST(tarjan_bridges)
+{
+    // two triangles joined by a link, with a tail
+    raven::graph::cGraph g;
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "a");
+    g.add("c", "d");
+    g.add("d", "e");
+    g.add("e", "f");
+    g.add("f", "d");
+    g.add("f", "g");
+
+    raven::graph::cTarjan T;
+    T.search(g);
+
+    std::vector<std::string> expAP{"c", "d", "f"};
+    CHECK(expAP == g.userName(T.articulationPoints()));
+
+    CHECK_EQUAL(2, T.bridges().size());
+    for (auto &b : T.bridges())
+    {
+        auto names = g.userName({std::min(b.first, b.second), std::max(b.first, b.second)});
+        CHECK((names[0] == "c" && names[1] == "d") || (names[0] == "f" && names[1] == "g"));
+    }
+
+    CHECK_EQUAL(4, T.biconnectedComponents().size());
+    int triangles = 0;
+    for (auto &c : T.biconnectedComponents())
+        if (c.size() == 3)
+            triangles++;
+    CHECK_EQUAL(2, triangles);
+
+    // long path, too deep for a recursive search
+    raven::graph::cGraph path;
+    for (int k = 0; k < 50000; k++)
+        path.add(k, k + 1);
+    T.search(path);
+    CHECK_EQUAL(49999, T.articulationPoints().size());
+    CHECK_EQUAL(50000, T.bridges().size());
+}
+
+TEST(cutsParallel)
+{
+    // ladder with a tail, big enough to share between threads
+    raven::graph::cGraph g;
+    int rungs = 10000;
+    for (int k = 0; k < rungs; k++)
+    {
+        g.add(2 * k, 2 * k + 1);
+        if (k)
+        {
+            g.add(2 * k - 2, 2 * k);
+            g.add(2 * k - 1, 2 * k + 1);
+        }
+    }
+    g.add(0, 2 * rungs);
+    g.add(2 * rungs, 2 * rungs + 1);
+
+    std::vector<int> vAP;
+    std::vector<std::pair<int, int>> vBridge;
+    cutsParallel(g, vAP, vBridge, 4);
+
+    raven::graph::cTarjan T;
+    T.search(g);
+    CHECK(vAP == T.articulationPoints());
+    CHECK_EQUAL(2, vAP.size());
+    CHECK_EQUAL(2, vBridge.size());
+    CHECK_EQUAL(T.bridges().size(), vBridge.size());
+}
+
 TEST(AP_so76642739_undirected)
 {
     raven::graph::sGraphData gd;
@@ -346,6 +526,49 @@ TEST(allpaths)
         gd.g.userName(act[1].first).begin()));
 }
 
+TEST(kShortestPaths)
+{
+    // https://en.wikipedia.org/wiki/Yen%27s_algorithm#Example
+    raven::graph::sGraphData gd;
+    gd.g.directed();
+    gd.edgeWeight.resize(9);
+    gd.edgeWeight[gd.g.add("C", "D")] = 3;
+    gd.edgeWeight[gd.g.add("C", "E")] = 2;
+    gd.edgeWeight[gd.g.add("D", "F")] = 4;
+    gd.edgeWeight[gd.g.add("E", "D")] = 1;
+    gd.edgeWeight[gd.g.add("E", "F")] = 2;
+    gd.edgeWeight[gd.g.add("E", "G")] = 3;
+    gd.edgeWeight[gd.g.add("F", "G")] = 2;
+    gd.edgeWeight[gd.g.add("F", "H")] = 1;
+    gd.edgeWeight[gd.g.add("G", "H")] = 2;
+    gd.startName = "C";
+    gd.endName = "H";
+
+    auto act = kShortestPaths(gd, 3);
+
+    CHECK_EQUAL(3, act.size());
+    CHECK_EQUAL(5, act[0].second);
+    CHECK_EQUAL(7, act[1].second);
+    CHECK_EQUAL(8, act[2].second);
+    std::vector<std::string> expected1{"C", "E", "F", "H"};
+    CHECK(std::equal(
+        expected1.begin(),
+        expected1.end(),
+        gd.g.userName(act[0].first).begin()));
+    std::vector<std::string> expected3{"C", "D", "F", "H"};
+    CHECK(std::equal(
+        expected3.begin(),
+        expected3.end(),
+        gd.g.userName(act[2].first).begin()));
+
+    CHECK_EQUAL(7, allPaths(gd).size());
+
+    raven::graph::cKShortestPaths gen(gd);
+    CHECK_EQUAL(5, gen.next().second);
+    CHECK_EQUAL(7, gen.next().second);
+    CHECK_EQUAL(2, gen.count());
+}
+
 TEST(probs)
 {
     raven::graph::sGraphData gd;
@@ -398,6 +621,54 @@ TEST(salesBBmetric)
         exp.end(),
         path.begin()));
 }
+TEST(salesBBthreads)
+{
+    // cities round a circle, every pair linked
+    const int n = 14;
+    raven::graph::cGraph g;
+    for (int v = 0; v < n; v++)
+        g.add(std::to_string(v));
+    for (int u = 0; u < n; u++)
+        for (int v = u + 1; v < n; v++)
+            g.add(u, v);
+    std::vector<double> weight(2 * g.edgeCount());
+    for (int u = 0; u < n; u++)
+        for (int v : g.adjacentOutRef(u))
+        {
+            // steps round the circle, far cities cost more
+            int steps = std::min(abs(u - v), n - abs(u - v));
+            weight[g.find(u, v)] = steps * steps;
+        }
+
+    raven::graph::cTSP one(g, weight), many(g, weight);
+    auto tour = one.calculate(1);
+    CHECK_EQUAL(n, one.TotalPathEdgeWeight());
+    CHECK_EQUAL(n + 1, tour.size());
+    CHECK_EQUAL(1, tour[1]);
+    CHECK(tour == many.calculate(4));
+    CHECK_EQUAL(n, many.TotalPathEdgeWeight());
+
+    // dynamic programming finds the same tour
+    raven::graph::cTSP dp(g, weight);
+    CHECK(tour == dp.calculateHeldKarp(4));
+    CHECK_EQUAL(n, dp.TotalPathEdgeWeight());
+
+    // 30 cities with random costs take tens of seconds, so a short time limit runs out
+    const int big = 30;
+    raven::graph::cGraph hard;
+    for (int v = 0; v < big; v++)
+        hard.add(std::to_string(v));
+    for (int u = 0; u < big; u++)
+        for (int v = u + 1; v < big; v++)
+            hard.add(u, v);
+    std::mt19937 rng(3);
+    std::vector<double> cost(2 * hard.edgeCount());
+    for (auto &c : cost)
+        c = 1 + rng() % 100;
+    raven::graph::cTSP timed(hard, cost);
+    CHECK(timed.calculate(1, 0.05).empty());
+    CHECK_EQUAL(INT_MAX, timed.TotalPathEdgeWeight());
+}
 TEST(salesBBnotmetric)
 {
     raven::graph::sGraphData gd;
@@ -412,6 +683,17 @@ TEST(salesBBnotmetric)
         exp.end(),
         path.begin()));
 }
+TEST(salesHeldKarp)
+{
+    raven::graph::sGraphData gd;
+    gd.fname = "../dat/tspnotmetric.txt";
+    readfile(gd);
+    raven::graph::cTSP tsp(gd.g, gd.edgeWeight);
+    auto path = gd.g.userName(tsp.calculateHeldKarp());
+    std::vector<std::string> exp{"0", "1", "3", "2", "0"};
+    CHECK_EQUAL(27, tsp.TotalPathEdgeWeight());
+    CHECK(exp == path);
+}
 TEST(salesmetric)
 {
     raven::graph::sGraphData gd;
@@ -473,65 +755,301 @@ TEST(components)
         svclique.begin()));
 }
 
-// TEST(dfs_allpaths)
-// {
-//     raven::graph::sGraphData gd;
-//     gd.g.directed();
-//     gd.g.add("0", "1");
-//     gd.g.add("0", "2");
-//     gd.g.add("0", "3");
-//     gd.g.add("2", "0");
-//     gd.g.add("2", "1");
-//     gd.g.add("1", "3");
-//     gd.startName = "2";
-//     gd.endName = "3";
-
-//     auto vpaths = dfs_allpaths(gd);
-
-//     CHECK_EQUAL(3, vpaths.size());
-//     std::vector<int> expected1{2, 1, 3};
-//     CHECK(std::equal(
-//         expected1.begin(),
-//         expected1.end(),
-//         vpaths[0].begin()));
-//     std::vector<int> expected2{2, 0, 3};
-//     CHECK(std::equal(
-//         expected2.begin(),
-//         expected2.end(),
-//         vpaths[1].begin()));
-//     std::vector<int> expected3{2, 0, 1, 3};
-//     CHECK(std::equal(
-//         expected3.begin(),
-//         expected3.end(),
-//         vpaths[2].begin()));
-// }
+TEST(componentLabels)
+{
+    raven::graph::sGraphData gd;
+    gd.fname = "../dat/components.txt";
+    readfile(gd);
+    auto label = componentLabels(gd.g, 4);
+    auto vcomp = raven::graph::componentGroups(label);
+    CHECK_EQUAL(2, vcomp.size());
+    for (auto &c : components(gd.g))
+    {
+        std::sort(c.begin(), c.end());
+        CHECK(c == vcomp[label[c[0]]]);
+    }
 
-// TEST(dfs_allpaths2)
-// {
-//     raven::graph::sGraphData gd;
-//     gd.g.add("a", "b");
-//     gd.g.add("b", "c");
-//     gd.g.add("a", "d");
-//     gd.g.add("d", "c");
-//     gd.startName = "a";
-//     gd.endName = "c";
+    // large enough to share between threads
+    raven::graph::cGraph g;
+    for (int k = 0; k < 20000; k++)
+        g.add(std::to_string(k));
+    for (int k = 0; k + 2 < 20000; k += 2)
+        g.add(k, k + 2);
+    label = componentLabels(g, 4);
+    CHECK_EQUAL(0, label[0]);
+    CHECK_EQUAL(1, label[1]);
+    CHECK_EQUAL(0, label[19998]);
+    CHECK_EQUAL(10000, label[19999]);
+    CHECK_EQUAL(2, label[3]);
+    CHECK_EQUAL(10001, raven::graph::componentGroups(label).size());
+}
+
+TEST(strongComponents)
+{
+    raven::graph::cGraph g;
+    g.directed();
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "a");
+    g.add("c", "d");
+    g.add("d", "e");
+    g.add("e", "d");
+    g.add("f", "d");
+
+    auto label = strongComponents(g);
+    CHECK_EQUAL(label[g.find("a")], label[g.find("b")]);
+    CHECK_EQUAL(label[g.find("a")], label[g.find("c")]);
+    CHECK_EQUAL(label[g.find("d")], label[g.find("e")]);
+    CHECK(label[g.find("a")] < label[g.find("d")]);
+    CHECK(label[g.find("f")] < label[g.find("d")]);
+    CHECK(label[g.find("a")] != label[g.find("f")]);
+
+    auto dag = condensation(g, label);
+    CHECK_EQUAL(3, dag.vertexCount());
+    CHECK_EQUAL(2, dag.edgeCount());
+
+    CHECK_EQUAL(3, components(g).size());
+
+    // deep enough to overflow a recursive search
+    raven::graph::cGraph chain;
+    chain.directed();
+    for (int k = 0; k < 50000; k++)
+        chain.add(k, k + 1);
+    chain.add(50000, 0);
+    label = strongComponents(chain);
+    CHECK_EQUAL(1, raven::graph::componentGroups(label).size());
+
+    // a component for every vertex, the condensation must not check each name against the rest
+    const int n = 200000;
+    raven::graph::cGraph line;
+    line.directed();
+    line.addVertices(n, "V");
+    for (int k = 0; k < n - 1; k++)
+        line.add(k, k + 1);
+    auto start = std::chrono::steady_clock::now();
+    label = strongComponents(line);
+    dag = condensation(line, label);
+    CHECK_EQUAL(n, dag.vertexCount());
+    CHECK_EQUAL(n - 1, dag.edgeCount());
+
+    // well under a second, a quadratic condensation takes about a minute
+    CHECK(std::chrono::steady_clock::now() - start < std::chrono::seconds(10));
+}
+
+TEST(dynamicConnectivity)
+{
+    raven::graph::cDynamicConnectivity dc(5);
+    CHECK_EQUAL(5, dc.componentCount());
+    dc.add(0, 1);
+    dc.add(1, 2);
+    dc.add(3, 4);
+    CHECK(dc.connected(0, 2));
+    CHECK(!dc.connected(0, 3));
+    CHECK_EQUAL(2, dc.componentCount());
+    dc.add(2, 6);
+    CHECK_EQUAL(7, dc.vertexCount());
+    CHECK_EQUAL(3, dc.componentCount());
+
+    raven::graph::cDynamicConnectivity del(0, true);
+    std::istringstream is(
+        "# 4 4\n"
+        "1 0 1\n"
+        "1 1 2\n"
+        "1 2 3\n"
+        "1 3 0\n"
+        "0 1 2\n"
+        "0 3 0\n");
+    std::vector<int> vCount;
+    CHECK_EQUAL(6, del.read(
+                       is, 4,
+                       [&](int ops)
+                       {
+                           vCount.push_back(del.componentCount());
+                           return true;
+                       }));
+    CHECK_EQUAL(2, vCount.size());
+    CHECK_EQUAL(1, vCount[0]);
+    CHECK_EQUAL(2, vCount[1]);
+    CHECK(del.connected(0, 1));
+    CHECK(!del.connected(1, 2));
+
+    // the header counts isolated vertices
+    raven::graph::cDynamicConnectivity header;
+    std::istringstream is2(
+        "# 6 1\n"
+        "1 0 1\n");
+    header.read(is2, 0, [](int ops)
+                { return true; });
+    CHECK_EQUAL(6, header.vertexCount());
+    CHECK_EQUAL(5, header.componentCount());
+
+    // a line that does not parse
+    std::istringstream bad("1 0 1\n1 2\n");
+    try
+    {
+        header.read(bad, 0, [](int ops)
+                    { return true; });
+        CHECK(false);
+    }
+    catch (std::runtime_error &e)
+    {
+    }
+}
 
-//     auto act = dfs_allpaths(gd);
+TEST(dfs_allpaths)
+{
+    raven::graph::sGraphData gd;
+    gd.g.directed();
+    gd.g.add("0", "1");
+    gd.g.add("0", "2");
+    gd.g.add("0", "3");
+    gd.g.add("2", "0");
+    gd.g.add("2", "1");
+    gd.g.add("1", "3");
+    gd.startName = "2";
+    gd.endName = "3";
 
-//     CHECK_EQUAL(2, act.size());
+    auto vpaths = dfs_allpaths(gd);
 
-//     std::vector<std::string> expected1{"a", "d", "c"};
-//     CHECK(std::equal(
-//         expected1.begin(),
-//         expected1.end(),
-//         gd.g.userName(act[0]).begin()));
+    CHECK_EQUAL(3, vpaths.size());
+    std::vector<int> expected1{2, 1, 3};
+    CHECK(std::equal(
+        expected1.begin(),
+        expected1.end(),
+        vpaths[0].begin()));
+    std::vector<int> expected2{2, 0, 3};
+    CHECK(std::equal(
+        expected2.begin(),
+        expected2.end(),
+        vpaths[1].begin()));
+    std::vector<int> expected3{2, 0, 1, 3};
+    CHECK(std::equal(
+        expected3.begin(),
+        expected3.end(),
+        vpaths[2].begin()));
+}
 
-//     std::vector<std::string> expected2{"a", "b", "c"};
-//     CHECK(std::equal(
-//         expected2.begin(),
-//         expected2.end(),
-//         gd.g.userName(act[1]).begin()));
-// }
+TEST(dfs_allpaths2)
+{
+    raven::graph::sGraphData gd;
+    gd.g.add("a", "b");
+    gd.g.add("b", "c");
+    gd.g.add("a", "d");
+    gd.g.add("d", "c");
+    gd.startName = "a";
+    gd.endName = "c";
+
+    auto act = dfs_allpaths(gd);
+
+    CHECK_EQUAL(2, act.size());
+
+    std::vector<std::string> expected1{"a", "d", "c"};
+    CHECK(std::equal(
+        expected1.begin(),
+        expected1.end(),
+        gd.g.userName(act[0]).begin()));
+
+    std::vector<std::string> expected2{"a", "b", "c"};
+    CHECK(std::equal(
+        expected2.begin(),
+        expected2.end(),
+        gd.g.userName(act[1]).begin()));
+}
+
+TEST(dfs_allpaths_visitor)
+{
+    raven::graph::sGraphData gd;
+    gd.fname = "../dat/allpaths.txt";
+    readfile(gd);
+    gd.g.add("b", "d");
+    int start = gd.g.find(gd.startName);
+    int end = gd.g.find(gd.endName);
+
+    int count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return true;
+        });
+    int all = count;
+    CHECK_EQUAL(5, all);
+
+    // stop after first path
+    count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return false;
+        });
+    CHECK_EQUAL(1, count);
+
+    // prune paths longer than the shortest
+    count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return true;
+        },
+        2);
+    CHECK_EQUAL(3, count);
+
+    // share the search between threads
+    count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return true;
+        },
+        0, -1, 4);
+    CHECK_EQUAL(all, count);
+
+    // prune paths costing more than two links
+    count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            CHECK(cost <= 2);
+            count++;
+            return true;
+        },
+        0, 2);
+    CHECK_EQUAL(3, count);
+    count = 0;
+    dfs_allpaths(
+        gd.g, {}, start, end,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return true;
+        },
+        0, 2, 4);
+    CHECK_EQUAL(3, count);
+
+    // every thread stops after the first path, in a graph with many paths
+    raven::graph::cGraph complete;
+    for (int u = 0; u < 9; u++)
+        for (int v = u + 1; v < 9; v++)
+            complete.add(u, v);
+    count = 0;
+    dfs_allpaths(
+        complete, {}, 0, 8,
+        [&](const raven::graph::path_t &path, double cost)
+        {
+            count++;
+            return false;
+        },
+        0, -1, 4);
+    CHECK_EQUAL(1, count);
+}
 
 TEST(vertexCover1)
 {
@@ -661,6 +1179,114 @@ TEST(cycle2notfullyconnected)
     CHECK_EQUAL(4, act[1].size());
 }
 
+TEST(elementaryCycles)
+{
+    raven::graph::cGraph g;
+    g.directed();
+    std::vector<std::string> vn{"a", "b", "c", "d"};
+    for (auto &u : vn)
+        for (auto &v : vn)
+            if (u != v)
+                g.add(u, v);
+
+    int count = 0;
+    elementaryCycles(
+        g,
+        [&](const raven::graph::path_t &cycle)
+        {
+            count++;
+            return true;
+        });
+    CHECK_EQUAL(20, count);
+
+    count = 0;
+    elementaryCycles(
+        g,
+        [&](const raven::graph::path_t &cycle)
+        {
+            count++;
+            return true;
+        },
+        3);
+    CHECK_EQUAL(14, count);
+
+    // stop after first cycle
+    count = 0;
+    elementaryCycles(
+        g,
+        [&](const raven::graph::path_t &cycle)
+        {
+            count++;
+            return false;
+        });
+    CHECK_EQUAL(1, count);
+
+    raven::graph::sGraphData gd;
+    for (int i = 0; i < vn.size(); i++)
+        for (int j = i + 1; j < vn.size(); j++)
+            gd.g.add(vn[i], vn[j]);
+    CHECK_EQUAL(7, dfs_cycle_finder(gd).size());
+}
+
+TEST(cycleSet)
+{
+    raven::graph::cCycleSet directed;
+    CHECK(directed.insert({3, 1, 2}));
+    CHECK(!directed.insert({1, 2, 3}));
+    CHECK(!directed.insert({2, 3, 1, 2}));
+    CHECK(directed.insert({1, 3, 2}));
+    CHECK_EQUAL(2, directed.size());
+
+    raven::graph::cCycleSet undirected(false);
+    CHECK(undirected.insert({4, 1, 2, 3}));
+    CHECK(!undirected.insert({1, 4, 3, 2}));
+    CHECK(undirected.insert({1, 3, 2, 4}));
+    CHECK(undirected.contains({2, 3, 1, 4, 2}));
+    CHECK_EQUAL(2, undirected.size());
+}
+
+TEST(cycleBasis)
+{
+    raven::graph::cGraph g;
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "d");
+    g.add("d", "a");
+    g.add("a", "c");
+    g.add("b", "e");
+    g.add("e", "f");
+
+    auto fundamental = cycleBasis(g);
+    CHECK_EQUAL(2, fundamental.size());
+
+    // the square is not in a minimum basis
+    auto minimum = minimumCycleBasis(g, {});
+    CHECK_EQUAL(2, minimum.size());
+    CHECK_EQUAL(4, minimum[0].size());
+    CHECK_EQUAL(4, minimum[1].size());
+
+    // expensive diagonal, now the square is cheaper than one triangle
+    std::vector<double> weight(2 * g.edgeCount(), 1);
+    weight[g.find("a", "c")] = 5;
+    weight[g.find("c", "a")] = 5;
+    minimum = minimumCycleBasis(g, weight);
+    CHECK_EQUAL(2, minimum.size());
+    CHECK_EQUAL(5, minimum[0].size());
+
+    CHECK_EQUAL(3, girth(g));
+    g.remove(g.find("a"), g.find("c"));
+    CHECK_EQUAL(4, girth(g));
+    g.remove(g.find("a"), g.find("b"));
+    CHECK_EQUAL(0, girth(g));
+
+    raven::graph::cGraph dg;
+    dg.directed();
+    dg.add("a", "b");
+    dg.add("b", "a");
+    dg.add("b", "c");
+    CHECK_EQUAL(2, girth(dg));
+}
+
 TEST(tourNodes)
 {
     raven::graph::sGraphData gd;
@@ -688,6 +1314,164 @@ TEST(tourNodes)
 
 
 
+TEST(tourNodesThreads)
+{
+    // a chain with vertex 0 in the middle, so the first perfect tour starts from an end
+    raven::graph::sGraphData gd;
+    gd.g.directed(false);
+    std::vector<int> chain;
+    for (int k = 1; k < 60; k++)
+        chain.push_back(k);
+    chain.push_back(0);
+    for (int k = 60; k < 120; k++)
+        chain.push_back(k);
+    for (int v = 0; v < 120; v++)
+        gd.g.add(std::to_string(v));
+    for (int k = 1; k < chain.size(); k++)
+        gd.g.add(chain[k - 1], chain[k]);
+    gd.edgeWeight.resize(2 * gd.g.edgeCount(), 1);
+
+    raven::graph::cTourNodes one, many;
+    one.calculate(gd, 1);
+    many.calculate(gd, 4);
+
+    CHECK_EQUAL(0, many.unvisitedCount());
+    CHECK_EQUAL(0, many.revisitedCount());
+    CHECK_EQUAL(120, many.getTour().size());
+    CHECK_EQUAL("1", gd.g.userName(many.getTour()[0]));
+    CHECK(one.getTour() == many.getTour());
+}
+
+TEST(tourOptimize)
+{
+    // square, tour backtracks through a
+    raven::graph::cGraph g;
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "d");
+    g.add("d", "a");
+    std::vector<double> weight(2 * g.edgeCount(), 1);
+    raven::graph::path_t tour;
+    for (auto &n : {"a", "b", "a", "d", "c"})
+        tour.push_back(g.find(n));
+    auto res = tourOptimize(g, weight, tour, 0);
+    CHECK_EQUAL(4, res.first.size());
+    CHECK_CLOSE(3, res.second, 0.01);
+
+    // points on a line, visited zig zag
+    raven::graph::cGraph line;
+    for (int v = 0; v < 8; v++)
+        line.add(std::to_string(v));
+    for (int u = 0; u < 8; u++)
+        for (int v = u + 1; v < 8; v++)
+            line.add(u, v);
+    std::vector<double> dist(2 * line.edgeCount());
+    for (int u = 0; u < 8; u++)
+        for (int v : line.adjacentOutRef(u))
+            dist[line.find(u, v)] = abs(u - v);
+    raven::graph::path_t zigzag{0, 4, 1, 5, 2, 6, 3, 7};
+    res = tourOptimize(line, dist, zigzag, 0);
+    CHECK_EQUAL(8, res.first.size());
+    CHECK_CLOSE(7, res.second, 0.01);
+    auto visited = res.first;
+    std::sort(visited.begin(), visited.end());
+    CHECK(visited == raven::graph::path_t({0, 1, 2, 3, 4, 5, 6, 7}));
+}
+
+TEST(spatialIndex)
+{
+    // 10 by 10 grid, point 10 * y + x
+    std::vector<double> x, y;
+    for (int i = 0; i < 10; i++)
+        for (int j = 0; j < 10; j++)
+        {
+            x.push_back(j);
+            y.push_back(i);
+        }
+    raven::graph::cSpatialIndex grid(x, y);
+    CHECK(grid.nearest(0, 3) == std::vector<int>({1, 10, 11}));
+    CHECK(grid.nearest(4.4, 4.4, 1) == std::vector<int>({44}));
+    CHECK(grid.within(5, 5, 1) == std::vector<int>({45, 54, 55, 56, 65}));
+    CHECK_EQUAL(0, grid.within(20, 20, 1).size());
+
+    // cities read from a sales file
+    raven::graph::cGraph g;
+    g.wVertexAttr(g.add("a"), {"0", "0"});
+    g.wVertexAttr(g.add("b"), {"5", "0"});
+    g.wVertexAttr(g.add("c"), {"1", "1"});
+    raven::graph::cSpatialIndex cities(g);
+    CHECK(cities.nearest(0, 2) == std::vector<int>({2, 1}));
+}
+
+TEST(euclideanGraph)
+{
+    // corners of a 3 by 4 rectangle, and its centre
+    raven::graph::cEuclideanGraph cities(
+        {0, 4, 4, 0, 2},
+        {0, 0, 3, 3, 1.5});
+    CHECK_CLOSE(5, cities.edgeWeight(0, 2), 0.0001);
+    std::vector<double> weight;
+    cities.edgeWeights(4, weight);
+    CHECK_EQUAL(5, weight.size());
+    CHECK_CLOSE(2.5, weight[1], 0.0001);
+    CHECK_CLOSE(0, weight[4], 0.0001);
+
+    raven::graph::cTSP tsp(cities);
+    auto tour = tsp.calculate();
+    CHECK(tour == std::vector<int>({0, 1, 2, 4, 3, 0}));
+    CHECK_EQUAL(15, tsp.TotalPathEdgeWeight());
+    CHECK(tour == tsp.calculateHeldKarp());
+
+    auto tree = raven::graph::spanningTreePrim(cities);
+    CHECK_EQUAL(4, tree.size());
+    double length = 0;
+    for (auto &l : tree)
+        length += cities.edgeWeight(l.first, l.second);
+    CHECK_CLOSE(10, length, 0.0001);
+}
+
+TEST(tourCities)
+{
+    // cities round a circle, numbered out of order
+    const int n = 200;
+    const double pi = 3.14159265358979;
+    std::vector<double> x(n), y(n);
+    for (int k = 0; k < n; k++)
+    {
+        int v = (k * 37) % n;
+        x[v] = cos(2 * pi * k / n);
+        y[v] = sin(2 * pi * k / n);
+    }
+    auto res = raven::graph::tourCities(x, y, 0);
+    CHECK_EQUAL(n + 1, res.first.size());
+    CHECK_EQUAL(0, res.first[0]);
+    CHECK_EQUAL(0, res.first.back());
+    CHECK_CLOSE(2 * n * sin(pi / n), res.second, 0.0001);
+    auto visited = res.first;
+    visited.pop_back();
+    std::sort(visited.begin(), visited.end());
+    for (int v = 0; v < n; v++)
+        CHECK_EQUAL(v, visited[v]);
+
+    // scattered cities, kicks for up to a second
+    std::mt19937 rng(1);
+    std::uniform_real_distribution<double> place(0, 100);
+    for (int v = 0; v < n; v++)
+    {
+        x[v] = place(rng);
+        y[v] = place(rng);
+    }
+    auto local = raven::graph::tourCities(x, y, 0);
+    auto kicked = raven::graph::tourCities(x, y, 1);
+    CHECK_EQUAL(n + 1, kicked.first.size());
+    CHECK(kicked.second <= local.second + 0.0001);
+    visited = kicked.first;
+    visited.pop_back();
+    std::sort(visited.begin(), visited.end());
+    for (int v = 0; v < n; v++)
+        CHECK_EQUAL(v, visited[v]);
+}
+
 TEST(removeLink)
 {
 
@@ -740,6 +1524,31 @@ TEST(removeLink)
     CHECK(g.find(g.find("a"), g.find("d")) >= -1);
 }
 
+TEST(removeLinkReversed)
+{
+    // undirected, removed with the higher vertex first
+    raven::graph::cGraph g;
+    g.add(0, 1);
+    g.add(1, 2);
+    CHECK_EQUAL(2, g.find(1, 2));
+
+    g.remove(2, 1);
+
+    CHECK_EQUAL(1, g.edgeCount());
+    auto vl = g.edgeList();
+    CHECK_EQUAL(1, vl.size());
+    CHECK(vl[0] == std::make_pair(0, 1));
+    CHECK_EQUAL(-1, g.find(1, 2));
+    CHECK_EQUAL(-1, g.find(2, 1));
+    for (int ei : {2, 3})
+    {
+        CHECK_EQUAL(-1, g.src(ei));
+        CHECK_EQUAL(-1, g.dest(ei));
+    }
+    CHECK_EQUAL(0, g.src(0));
+    CHECK_EQUAL(1, g.dest(0));
+}
+
 TEST(edgebyindex)
 {
     raven::graph::cGraph g;
@@ -830,6 +1639,81 @@ TEST(spanningTree)
         res.begin()));
 }
 
+TEST(spanningTreeKruskal)
+{
+    raven::graph::cGraph g;
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "a");
+    g.add("c", "d");
+    g.add("e", "f");
+    std::vector<double> weight(2 * g.edgeCount(), 1);
+    weight[g.find("a", "b")] = 5;
+    weight[g.find("b", "a")] = 5;
+
+    auto forest = spanningTreeKruskal(g, weight);
+    CHECK_EQUAL(4, forest.size());
+    double cost = 0;
+    for (int ei : forest)
+        cost += weight[ei];
+    CHECK_CLOSE(4, cost, 0.01);
+
+    auto tree = spanningTreePrim(g, weight, g.find("a"));
+    CHECK_EQUAL(3, tree.size());
+    CHECK_EQUAL(g.find("a"), g.src(tree[0]));
+    CHECK_EQUAL(g.find("c"), g.dest(tree[0]));
+
+    auto sg = spanningGraph(g, forest);
+    CHECK_EQUAL(6, sg.vertexCount());
+    CHECK_EQUAL(4, sg.edgeCount());
+    CHECK_EQUAL(-1, sg.find(g.find("a"), g.find("b")));
+}
+
+TEST(spanningForestBoruvka)
+{
+    raven::graph::cGraph g;
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "a");
+    g.add("c", "d");
+    g.add("e", "f");
+    g.add("f", "g");
+    g.add("g", "e");
+    g.add("h");
+    std::vector<double> weight(2 * g.edgeCount(), 1);
+    weight[g.find("a", "b")] = 5;
+    weight[g.find("b", "a")] = 5;
+    weight[g.find("f", "g")] = 3;
+    weight[g.find("g", "f")] = 3;
+
+    auto forest = spanningForestBoruvka(g, weight, 4);
+    CHECK_EQUAL(5, forest.size());
+    double cost = 0;
+    for (int ei : forest)
+        cost += weight[ei];
+    CHECK_CLOSE(5, cost, 0.01);
+
+    // same cost as Kruskal on a large random graph, shared between threads
+    raven::graph::cGraph big;
+    for (int v = 0; v < 20000; v++)
+        big.add(std::to_string(v));
+    srand(42);
+    for (int k = 0; k < 40000; k++)
+        big.add(rand() % 20000, rand() % 20000);
+    std::vector<double> bigWeight(2 * big.edgeCount());
+    for (auto &w : bigWeight)
+        w = rand() % 100;
+    double costKruskal = 0, costBoruvka = 0;
+    auto kruskal = spanningTreeKruskal(big, bigWeight);
+    for (int ei : kruskal)
+        costKruskal += bigWeight[ei];
+    auto boruvka = spanningForestBoruvka(big, bigWeight, 4);
+    for (int ei : boruvka)
+        costBoruvka += bigWeight[ei];
+    CHECK_EQUAL(kruskal.size(), boruvka.size());
+    CHECK_CLOSE(costKruskal, costBoruvka, 0.01);
+}
+
 TEST(dfs)
 {
     raven::graph::cGraph g;
@@ -852,6 +1736,90 @@ TEST(dfs)
         g.userName(visited).begin()));
 }
 
+TEST(dfsEvents)
+{
+    raven::graph::cGraph g;
+    g.directed();
+    g.add("a", "b");
+    g.add("b", "c");
+    g.add("c", "a");
+    g.add("a", "d");
+
+    struct sEvents : public raven::graph::sTraversalEvents
+    {
+        std::vector<int> post;
+        int back = 0;
+        void finish(int v) { post.push_back(v); }
+        void backEdge(int u, int v) { back++; }
+    } events;
+    dfsEvents(g, g.find("a"), events);
+
+    std::vector<std::string> expected{"c", "b", "d", "a"};
+    CHECK(std::equal(
+        expected.begin(),
+        expected.end(),
+        g.userName(events.post).begin()));
+    CHECK_EQUAL(1, events.back);
+
+    // bfs visits every reachable vertex once
+    std::vector<int> visited;
+    bfs(g, g.find("a"),
+        [&](int v)
+        {
+            visited.push_back(v);
+            return true;
+        });
+    std::vector<std::string> bexp{"a", "b", "d", "c"};
+    CHECK(std::equal(
+        bexp.begin(),
+        bexp.end(),
+        g.userName(visited).begin()));
+}
+
+TEST(searchWorkspace)
+{
+    raven::graph::sGraphData gd;
+    gd.g.add("a", "b");
+    gd.g.add("b", "c");
+    gd.g.add("a", "d");
+    gd.g.add("d", "c");
+    gd.g.add("e", "f");
+    gd.edgeWeight.resize(2 * gd.g.edgeCount(), 1);
+    gd.edgeWeight[gd.g.find("a", "b")] = 5;
+    gd.edgeWeight[gd.g.find("b", "a")] = 5;
+
+    // one workspace reused for many searches
+    raven::graph::cSearchWorkspace work;
+    for (int k = 0; k < 3; k++)
+    {
+        dijsktra(gd.g, gd.edgeWeight, gd.g.find("a"), -1, work);
+        CHECK_CLOSE(2, work.dist(gd.g.find("c")), 0.01);
+        CHECK_CLOSE(3, work.dist(gd.g.find("b")), 0.01);
+        CHECK_EQUAL(gd.g.find("c"), work.pred(gd.g.find("b")));
+        CHECK_EQUAL(-1, work.pred(gd.g.find("e")));
+        CHECK_EQUAL(INT_MAX, work.dist(gd.g.find("f")));
+
+        gd.startName = "a";
+        gd.endName = "c";
+        CHECK_EQUAL(3, bfsPath(gd, work).size());
+        gd.endName = "f";
+        CHECK_EQUAL(0, bfsPath(gd, work).size());
+
+        CHECK_EQUAL(2, components(gd.g, work).size());
+
+        int count = 0;
+        dfs(
+            gd.g, gd.g.find("e"),
+            [&](int v)
+            {
+                count++;
+                return true;
+            },
+            work);
+        CHECK_EQUAL(2, count);
+    }
+}
+
 TEST(tourNodes2)
 {
     raven::graph::sGraphData gd;
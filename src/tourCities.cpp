@@ -0,0 +1,419 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <deque>
+#include <numeric>
+#include <random>
+#include <tuple>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        path_cost_t tourCities(
+            const std::vector<double> &x,
+            const std::vector<double> &y,
+            double seconds)
+        {
+            return tourCities(cSpatialIndex(x, y), seconds);
+        }
+
+        path_cost_t tourCities(
+            const cSpatialIndex &cities,
+            double seconds)
+        {
+            const auto &x = cities.x();
+            const auto &y = cities.y();
+
+            // candidate neighbours of each city
+            const int neighbours = 8;
+
+            // improvements smaller than this are rounding errors
+            const double epsilon = 1e-9;
+
+            auto stop = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(seconds));
+
+            int n = x.size();
+            auto dist = [&](int u, int v) -> double
+            {
+                double dx = x[u] - x[v];
+                double dy = y[u] - y[v];
+                return std::sqrt(dx * dx + dy * dy);
+            };
+
+            path_t t(n);
+            std::iota(t.begin(), t.end(), 0);
+            if (n > 3)
+            {
+                std::vector<std::vector<int>> near(n);
+                for (int v = 0; v < n; v++)
+                    near[v] = cities.nearest(v, neighbours);
+
+                /* starting tour, a walk round a minimum spanning tree of the links to near neighbours
+
+                If the near neighbour links do not join every city,
+                the walk jumps from one tree to the next
+                */
+                std::vector<std::pair<int, int>> vLink;
+                for (int v = 0; v < n; v++)
+                    for (int w : near[v])
+                        vLink.push_back(std::make_pair(std::min(v, w), std::max(v, w)));
+                std::sort(vLink.begin(), vLink.end());
+                vLink.erase(std::unique(vLink.begin(), vLink.end()), vLink.end());
+                std::stable_sort(
+                    vLink.begin(), vLink.end(),
+                    [&](const std::pair<int, int> &a, const std::pair<int, int> &b)
+                    {
+                        return dist(a.first, a.second) < dist(b.first, b.second);
+                    });
+                std::vector<int> parent(n);
+                std::iota(parent.begin(), parent.end(), 0);
+                auto root = [&](int v)
+                {
+                    while (parent[v] != v)
+                    {
+                        parent[v] = parent[parent[v]];
+                        v = parent[v];
+                    }
+                    return v;
+                };
+                std::vector<std::vector<int>> tree(n);
+                for (auto &l : vLink)
+                {
+                    int a = root(l.first);
+                    int b = root(l.second);
+                    if (a == b)
+                        continue;
+                    parent[std::max(a, b)] = std::min(a, b);
+                    tree[l.first].push_back(l.second);
+                    tree[l.second].push_back(l.first);
+                }
+                t.clear();
+                std::vector<bool> visited(n, false);
+                std::vector<int> wait;
+                for (int start = 0; start < n; start++)
+                {
+                    if (visited[start])
+                        continue;
+                    wait.push_back(start);
+                    visited[start] = true;
+                    while (!wait.empty())
+                    {
+                        int v = wait.back();
+                        wait.pop_back();
+                        t.push_back(v);
+                        for (auto it = tree[v].rbegin(); it != tree[v].rend(); it++)
+                            if (!visited[*it])
+                            {
+                                visited[*it] = true;
+                                wait.push_back(*it);
+                            }
+                    }
+                }
+
+                // tour position of each city
+                std::vector<int> pos(n);
+                for (int p = 0; p < n; p++)
+                    pos[t[p]] = p;
+                auto succ = [&](int v)
+                {
+                    int p = pos[v] + 1;
+                    return t[p == n ? 0 : p];
+                };
+                auto pred = [&](int v)
+                {
+                    int p = pos[v] - 1;
+                    return t[p < 0 ? n - 1 : p];
+                };
+                auto step = [&](int v, int dir)
+                {
+                    return dir > 0 ? succ(v) : pred(v);
+                };
+
+                /* reversals since a kick, so a kick that does not pay can be undone
+
+                Each is the first position, last position and length of the reversal
+                */
+                std::vector<std::tuple<int, int, int>> journal;
+                bool fKick = false;
+
+                // reverse len cities from position i forwards to position j
+                auto reverseAt = [&](int i, int j, int len)
+                {
+                    for (int k = 0; k < len / 2; k++)
+                    {
+                        int a = i + k;
+                        int b = j - k;
+                        if (a >= n)
+                            a -= n;
+                        if (b < 0)
+                            b += n;
+                        std::swap(t[a], t[b]);
+                        pos[t[a]] = a;
+                        pos[t[b]] = b;
+                    }
+                };
+
+                // reverse the tour from u forwards to v, or the rest of the tour if that is shorter
+                auto reverse = [&](int u, int v)
+                {
+                    int i = pos[u];
+                    int j = pos[v];
+                    int len = j - i + 1;
+                    if (len <= 0)
+                        len += n;
+                    if (2 * len > n)
+                    {
+                        i = pos[v] + 1;
+                        j = pos[u] - 1;
+                        len = n - len;
+                    }
+                    if (i >= n)
+                        i -= n;
+                    if (j < 0)
+                        j += n;
+                    reverseAt(i, j, len);
+                    if (fKick)
+                        journal.emplace_back(i, j, len);
+                };
+
+                /* replace links a-b and c-d with a-c and b-d
+
+                b and d must follow a and c in the same direction round the tour
+                */
+                auto flip = [&](int a, int b, int c, int d)
+                {
+                    if (succ(a) == b)
+                        reverse(b, c);
+                    else
+                        reverse(a, d);
+                };
+
+                /* don't look bits
+
+                Cities wait in the queue until no move from them shortens the tour.
+                A city is queued again when a move changes one of its links.
+                */
+                std::deque<int> active;
+
+                // total of the improvements made by moves
+                double gained = 0;
+
+                std::vector<bool> fActive(n, false);
+                auto wake = [&](int v)
+                {
+                    if (fActive[v])
+                        return;
+                    fActive[v] = true;
+                    active.push_back(v);
+                };
+
+                /* 2-opt
+
+                Replace the link from a to its neighbour b
+                with a link to one of a's candidate neighbours
+                */
+                auto twoOpt = [&](int a) -> bool
+                {
+                    for (int dir : {1, -1})
+                    {
+                        int b = step(a, dir);
+                        double ab = dist(a, b);
+                        for (int c : near[a])
+                        {
+                            double gain = ab - dist(a, c);
+                            if (gain <= epsilon)
+                                break;
+                            int d = step(c, dir);
+                            if (c == b || d == a)
+                                continue;
+                            gain += dist(c, d) - dist(b, d);
+                            if (gain <= epsilon)
+                                continue;
+                            flip(a, b, c, d);
+                            gained += gain;
+                            wake(a);
+                            wake(b);
+                            wake(c);
+                            wake(d);
+                            return true;
+                        }
+                    }
+                    return false;
+                };
+
+                /* Or-opt
+
+                Move a run of up to 3 cities, starting at a, between two neighbouring cities u and w,
+                one of them a candidate neighbour of a, the run either way round
+                */
+                auto orOpt = [&](int a) -> bool
+                {
+                    for (int dir : {1, -1})
+                    {
+                        int p = step(a, -dir);
+                        int e = a;
+                        for (int len = 1; len <= 3 && len + 3 <= n; len++)
+                        {
+                            if (len > 1)
+                                e = step(e, dir);
+                            int nx = step(e, dir);
+                            if (nx == p)
+                                break;
+
+                            // saving from taking the run out
+                            double gain = dist(p, a) + dist(e, nx) - dist(p, nx);
+                            if (gain <= epsilon)
+                                continue;
+
+                            auto inRun = [&](int v)
+                            {
+                                for (int r = a;; r = step(r, dir))
+                                {
+                                    if (r == v)
+                                        return true;
+                                    if (r == e)
+                                        return false;
+                                }
+                            };
+
+                            for (int c : near[a])
+                            {
+                                double ca = dist(c, a);
+                                if (ca >= gain - epsilon)
+                                    break;
+                                if (inRun(c))
+                                    continue;
+
+                                // u, a ... e, w or u, e ... a, w
+                                for (int side : {1, -1})
+                                {
+                                    int u = (side > 0) ? c : step(c, -dir);
+                                    int w = step(u, dir);
+                                    if (w == p || u == p || inRun(u) || inRun(w))
+                                        continue;
+                                    double extra = (side > 0)
+                                                       ? ca + dist(e, w) - dist(u, w)
+                                                       : dist(u, e) + ca - dist(u, w);
+                                    if (extra >= gain - epsilon)
+                                        continue;
+
+                                    flip(p, a, u, w);
+                                    if (u != nx)
+                                        flip(p, u, nx, e);
+                                    if (side > 0 && a != e)
+                                        flip(u, e, a, w);
+                                    gained += gain - extra;
+                                    wake(p);
+                                    wake(nx);
+                                    wake(u);
+                                    wake(w);
+                                    wake(a);
+                                    wake(e);
+                                    return true;
+                                }
+                            }
+                        }
+                    }
+                    return false;
+                };
+
+                // the clock is slow to read, so look only now and then
+                int checks = 0;
+                auto late = [&]()
+                {
+                    return seconds > 0 &&
+                           ++checks % 256 == 0 &&
+                           std::chrono::steady_clock::now() > stop;
+                };
+
+                // make moves until none shortens the tour, return false if out of time
+                auto improve = [&]() -> bool
+                {
+                    while (!active.empty())
+                    {
+                        if (late())
+                            return false;
+                        int v = active.front();
+                        active.pop_front();
+                        fActive[v] = false;
+                        if (twoOpt(v) || orOpt(v))
+                            wake(v);
+                    }
+                    return true;
+                };
+
+                for (int v : t)
+                    wake(v);
+                bool fTime = improve();
+
+                /* kicks, while there is time left and they still pay
+
+                Two short runs of cities, next to each other in the tour, swap places ( a double bridge move ).
+                Moves from the cities with changed links then shorten the tour.
+                The kick is undone if the tour is no shorter than it was.
+                */
+                std::mt19937 rng(0);
+                int maxRun = std::min(50, n / 8);
+
+                // kicks in a row that do not shorten the tour before giving up, each changes only a few links
+                const int staleKicks = std::max(1000, n);
+                int stale = 0;
+
+                fKick = true;
+                while (fTime && seconds > 0 && maxRun > 0 && stale < staleKicks)
+                {
+                    int i = rng() % n;
+                    int runA = 1 + rng() % maxRun;
+                    int runB = 1 + rng() % maxRun;
+                    int p = t[i];
+                    int a0 = t[(i + 1) % n];
+                    int a1 = t[(i + runA) % n];
+                    int b0 = t[(i + runA + 1) % n];
+                    int b1 = t[(i + runA + runB) % n];
+                    int q = t[(i + runA + runB + 1) % n];
+                    double kick = dist(p, b0) + dist(b1, a0) + dist(a1, q) -
+                                  dist(p, a0) - dist(a1, b0) - dist(b1, q);
+
+                    // p a0..a1 b0..b1 q becomes p b0..b1 a0..a1 q
+                    journal.clear();
+                    reverse(a0, b1);
+                    reverse(b1, b0);
+                    reverse(a1, a0);
+                    gained = 0;
+                    for (int v : {p, a0, a1, b0, b1, q})
+                        wake(v);
+                    fTime = improve();
+
+                    if (gained - kick > epsilon)
+                        stale = 0;
+                    else
+                        stale++;
+
+                    if (gained - kick < -epsilon || !fTime)
+                    {
+                        // undo
+                        for (int v : active)
+                            fActive[v] = false;
+                        active.clear();
+                        for (auto it = journal.rbegin(); it != journal.rend(); it++)
+                            reverseAt(std::get<0>(*it), std::get<1>(*it), std::get<2>(*it));
+                    }
+                }
+
+                // start at city 0
+                std::rotate(t.begin(), t.begin() + pos[0], t.end());
+            }
+
+            double total = 0;
+            if (n)
+                t.push_back(t[0]);
+            for (int p = 1; p < t.size(); p++)
+                total += dist(t[p - 1], t[p]);
+            return std::make_pair(t, total);
+        }
+    }
+}
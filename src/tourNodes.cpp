@@ -1,7 +1,11 @@
 
 #include <algorithm>
+#include <atomic>
 #include <iostream>
+#include <mutex>
 #include <stack>
+#include <thread>
+#include <tuple>
 #include "GraphTheory.h"
 
 namespace raven
@@ -27,8 +31,8 @@ namespace raven
             if (dfsStart == -3)
                 return false;
 
-            // std::cout << "jump " << spanTree.userName(v)
-            //           << " to " << spanTree.userName(dfsStart) << "\n";
+            // std::cout << "jump " << mySpan.g.userName(v)
+            //           << " to " << mySpan.g.userName(dfsStart) << "\n";
 
             // start a new dfs starting from the unvisited leaf
             return false;
@@ -37,48 +41,43 @@ namespace raven
         int cTourNodes::isLeafJump(int v)
         {
             // check if at a leaf
-            if (std::find(
-                    vleaf.begin(),
-                    vleaf.end(),
-                    v) == vleaf.end())
+            if (!isLeaf[v])
                 return -1; // no jump required
 
             // std::cout << "at leaf " << g->userName(v) << "\n";
 
             // reached a leaf of the spanning tree
             // check if we reached this leaf by jumping
-            if (!spanVisited[spanTree.adjacentOut(v)[0]])
+            if (!spanVisited[mySpan.g.adjacentOutRef(v)[0]])
                 return -1; // no jump required
 
-            // jump to an unvisted leaf
-            for (int f : vleaf)
+            // jump to the lowest index unvisited leaf linked to v in the original graph
+            int jump = -3;
+            for (int f : g->adjacentOutRef(v))
             {
-                if (f == v)
+                if (f == v || !isLeaf[f] || spanVisited[f])
                     continue;
-
-                // check other leaf unvisited
-                if (spanVisited[f])
-                    continue;
-
-                // check for link to other leaf in original graph
-                if (g->find(v, f) != -1)
-                    return f;
+                if (jump < 0 || f < jump)
+                    jump = f;
             }
 
-            // no reachable unvisited leaves
-            return -3;
+            // -3 if no reachable unvisited leaves
+            return jump;
         }
 
         void cTourNodes::tourNodesAdd(
             int v)
         {
 
-            // std::cout << "add " << spanTree.userName(v) <<" "<< unvisited<< "\n";
+            // std::cout << "add " << mySpan.g.userName(v) <<" "<< unvisited<< "\n";
             if (spanVisited[v])
             {
                 // revisited node
-                if (std::find(revisited.begin(), revisited.end(), v) == revisited.end())
+                if (!isRevisited[v])
+                {
+                    isRevisited[v] = true;
                     revisited.push_back(v);
+                }
             }
             else
                 unvisited--;
@@ -87,7 +86,71 @@ namespace raven
             tour.push_back(v);
         }
 
-        void cTourNodes::calculate(sGraphData &gd)
+        bool cTourNodes::tourFrom(
+            sGraphData &gd,
+            int spanTreeRoot)
+        {
+            // find a spanning tree
+            // note: spanningTree() keeps the graph's vertex indices
+            // the quiet version, workers on other threads must not write to std::cout
+
+            mySpan.g = spanningTree(gd.g, gd.edgeWeight, spanTreeRoot);
+            if (!mySpan.g.vertexCount())
+                return false;
+
+            // find spanning tree leaves
+            int n = mySpan.g.vertexCount();
+            isLeaf.assign(n, false);
+            for (int v = 0; v < n; v++)
+            {
+                if (mySpan.g.adjacentOutRef(v).size() == 1)
+                    isLeaf[v] = true;
+            }
+
+            tour.clear();
+            spanVisited.assign(n, false);
+            isRevisited.assign(n, false);
+            revisited.clear();
+            dfsStart = spanTreeRoot;
+            unvisited = n;
+            int prevUnvisited = unvisited + 1;
+
+            // while unvisited nodes remain
+            while (unvisited)
+            {
+                // check on progress
+                if (dfsStart == -2)
+                    break;
+                if (dfsStart == -3)
+                {
+                    // stuck on a leaf with no one hop reachable unvisited nodes
+                    // std::cout << "stuck on " << g->userName(tour.back()) << "\n";
+                    dfsStart = PathToUnvisited(tour.back());
+                    if (dfsStart < 0)
+                        break;
+                }
+                if (unvisited == prevUnvisited)
+                    break;
+                prevUnvisited = unvisited;
+
+                // std::cout << "dfs " << dfsStart << " "<< g->userName(dfsStart) << ", ";
+
+                // depth first search
+                dfs(
+                    mySpan.g,
+                    dfsStart,
+                    [this](int v)
+                    {
+                        return visitor(v);
+                    },
+                    myWork);
+            }
+            return true;
+        }
+
+        void cTourNodes::calculate(
+            sGraphData &gd,
+            int threads)
         {
             if (!gd.g.vertexCount())
             {
@@ -98,11 +161,6 @@ namespace raven
             g = &gd.g;
             myEdgeWeights = gd.edgeWeight;
 
-            tour.clear();
-            auto best = tour;
-            int bestUnvisited = INT_MAX;
-            std::vector<int> bestRevisited;
-
             int vstart, vend;
             if (gd.startName.empty())
             {
@@ -114,157 +172,187 @@ namespace raven
                 vstart = g->find(gd.startName);
                 vend = vstart + 1;
             }
-            // loop over nodes, starting the spanning tree at each
-            for (int spanTreeRoot = vstart; spanTreeRoot < vend; spanTreeRoot++)
-            {
-                // find a spanning tree
-                // note: spanTree.userName( vi ) == g.userName( vi )
 
-                gd.startName = gd.g.userName(spanTreeRoot);
-                spanTree = spanningTree(gd);
-                if (!spanTree.vertexCount())
-                    continue;
+            // roots tried on the calling thread alone
+            const int parallelRoots = 100;
 
-                // find spanning tree leaves
-                for (int v = 0; v < spanTree.vertexCount(); v++)
-                {
-                    if (spanTree.adjacentOut(v).size() == 1)
-                        vleaf.push_back(v);
-                }
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 1 || vend - vstart < parallelRoots)
+                threads = 1;
+
+            /* the best tour has fewest unvisited, then fewest revisited, then lowest root,
+            the one a search of the roots in order keeping only strict improvements finds.
+            A perfect tour is best of all, so roots after the first perfect one need not be tried
+            */
+            std::mutex mtx;
+            int bestRoot = -1;
+            int bestUnvisited = INT_MAX;
+            int bestRevisited = INT_MAX;
+            std::atomic<int> nextRoot(vstart);
+            std::atomic<int> perfectRoot(vend);
+
+            // revisited and unvisited counts from each root, -1 if no spanning tree
+            std::vector<std::pair<int, int>> vCount(vend - vstart, std::make_pair(-1, -1));
 
-                spanVisited.clear();
-                spanVisited.resize(spanTree.vertexCount(), false);
-                revisited.clear();
-                dfsStart = spanTreeRoot;
-                unvisited = spanTree.vertexCount();
-                int prevUnvisited = unvisited + 1;
+            std::exception_ptr error;
 
-                // while unvisited nodes remain
-                while (unvisited)
+            auto work = [&]()
+            {
+                // per thread copies, the search from each root changes them
+                cTourNodes worker;
+                worker.g = g;
+                worker.myEdgeWeights = myEdgeWeights;
+                sGraphData wgd;
+                wgd.g = gd.g;
+                wgd.edgeWeight = gd.edgeWeight;
+
+                try
                 {
-                    // check on progress
-                    if (dfsStart == -2)
-                        break;
-                    if (dfsStart == -3)
+                    while (true)
                     {
-                        // stuck on a leaf with no one hop reachable unvisited nodes
-                        // std::cout << "stuck on " << g->userName(tour.back()) << "\n";
-                        dfsStart = PathToUnvisited();
-                        if (dfsStart < 0)
-                            break;
+                        int root = nextRoot++;
+                        if (root >= perfectRoot.load())
+                            return;
+
+                        if (!worker.tourFrom(wgd, root))
+                            continue;
+                        vCount[root - vstart] = std::make_pair(
+                            (int)worker.revisited.size(),
+                            worker.unvisited);
+
+                        std::lock_guard<std::mutex> lock(mtx);
+                        if (std::make_tuple(worker.unvisited, (int)worker.revisited.size(), root) <
+                            std::make_tuple(bestUnvisited, bestRevisited, bestRoot < 0 ? INT_MAX : bestRoot))
+                        {
+                            bestRoot = root;
+                            bestUnvisited = worker.unvisited;
+                            bestRevisited = worker.revisited.size();
+                            tour = worker.tour;
+                            unvisited = worker.unvisited;
+                            revisited = worker.revisited;
+                            mySpan.g = worker.mySpan.g;
+                            if (!unvisited && !revisited.size())
+                                perfectRoot = root;
+                        }
                     }
-                    if (unvisited == prevUnvisited)
-                        break;
-                    prevUnvisited = unvisited;
-
-                    // std::cout << "dfs " << dfsStart << " "<< g->userName(dfsStart) << ", ";
-
-                    // depth first search
-                    dfs(
-                        spanTree,
-                        dfsStart,
-                        std::bind(
-                            cTourNodes::visitor, this,
-                            std::placeholders::_1));
                 }
-
-                std::cout << "tourNodes revisited " << revisited.size()
-                          << " unvisited " << unvisited
-                          << " start " << g->userName(spanTreeRoot)
-                          << " ( " << spanTreeRoot << " )"
-                          << "\n";
-
-                // check for 'perfect' tour
-                if ((!revisited.size()) && (!unvisited))
+                catch (...)
                 {
-                    tour = vectorgraphIndexFromSpanIndex(tour);
-                    return;
+                    std::lock_guard<std::mutex> lock(mtx);
+                    if (!error)
+                        error = std::current_exception();
+                    perfectRoot = -1;
                 }
+            };
 
-                bool improve = false;
-                if (unvisited < bestUnvisited)
-                {
-                    best = vectorgraphIndexFromSpanIndex(tour);
-                    bestUnvisited = unvisited;
-                    bestRevisited = revisited;
-                    improve = true;
-                }
-                else if (unvisited == bestUnvisited)
+            tour.clear();
+            revisited.clear();
+            unvisited = bestUnvisited;
+            if (threads == 1)
+                work();
+            else
+            {
+                std::vector<std::thread> vThread;
+                for (int t = 0; t < threads; t++)
+                    vThread.emplace_back(work);
+                for (auto &t : vThread)
+                    t.join();
+            }
+            if (error)
+                std::rethrow_exception(error);
+
+            // report in root order, as far as the first perfect tour
+            for (int root = vstart; root < vend && root <= perfectRoot; root++)
+            {
+                auto &c = vCount[root - vstart];
+                if (c.first < 0)
                 {
-                    if (revisited.size() < bestRevisited.size())
-                    {
-                        best = vectorgraphIndexFromSpanIndex(tour);
-                        bestUnvisited = unvisited;
-                        bestRevisited = revisited;
-                        improve = true;
-                    }
+                    std::cout << "spanning tree starting from " << g->userName(root)
+                              << " cannot reach every vertex\n";
+                    continue;
                 }
-                tour.clear();
+                std::cout << "tourNodes revisited " << c.first
+                          << " unvisited " << c.second
+                          << " start " << g->userName(root)
+                          << " ( " << root << " )"
+                          << "\n";
             }
 
+            if (perfectRoot < vend)
+                return;
+
             std::cout << "bestPath ";
-            for (int isp : best)
+            for (int isp : tour)
                 std::cout << g->userName(isp) << ' ';
             std::cout << "\n\n";
-
-            tour = best;
-            unvisited = bestUnvisited;
-            revisited = bestRevisited;
         }
 
-        int cTourNodes::PathToUnvisited()
+        int cTourNodes::PathToUnvisited(int start)
         {
-            // find nearbye unvisited vertex
+            // find the last unvisited vertex reached by a breadth first search of the graph
             int target = -1;
             bfs(
                 *g,
-                tour.back(),
+                start,
                 [&](int v) -> bool
                 {
-                    if (spanVisited[v])
-                        return true;
-                    target = v;
+                    if (!spanVisited[v])
+                        target = v;
                     return true;
-                });
-            if( target < 0 )
+                },
+                myWork);
+            if (target < 0)
                 return -1;
-                
-            // find best path from last node in tour
-            // allowing node revisits
-            sGraphData gd;
-            gd.g = spanTree;
-            gd.edgeWeight = myEdgeWeights;
-            gd.startName = g->userName(tour.back());
-            gd.endName = g->userName(target);
-            auto bestPath = bfsPath(gd);
-
-            if (!bestPath.size())
+
+            // path along the spanning tree, allowing node revisits
+            // links whose graph edge weight is zero are not used, as bfsPath() does
+            myWork.start(mySpan.g.vertexCount());
+            auto &Q = myWork.waiting();
+            int front = 0;
+            Q.push_back(start);
+            myWork.visit(start);
+            bool found = false;
+            while (front < Q.size() && !found)
+            {
+                int v = Q[front++];
+                for (int u : mySpan.g.adjacentOutRef(v))
+                {
+                    int ei = mySpan.g.find(v, u);
+                    if (ei < myEdgeWeights.size() && myEdgeWeights[ei] == 0)
+                        continue;
+                    if (u == target)
+                    {
+                        myWork.pred(u, v);
+                        found = true;
+                        break;
+                    }
+                    if (myWork.isVisited(u))
+                        continue;
+                    Q.push_back(u);
+                    myWork.pred(u, v);
+                    myWork.visit(u);
+                }
+            }
+            if (!found)
                 return -1;
 
             // add path to tour, except for first and last node
-            for (
-                auto it = bestPath.begin() + 1;
-                it != bestPath.end() - 1;
-                it++)
+            std::vector<int> path;
+            for (int v = myWork.pred(target); v != start; v = myWork.pred(v))
+                path.push_back(v);
+            for (auto it = path.rbegin(); it != path.rend(); it++)
                 tourNodesAdd(*it);
 
             // return last node in path
             // the next DFS will start here
-            return bestPath.back();
-        }
-
-        std::vector<int> cTourNodes::vectorgraphIndexFromSpanIndex(const std::vector<int> &visp)
-        {
-            std::vector<int> ret;
-            for (int isp : visp)
-                ret.push_back(g->find(spanTree.userName(isp)));
-            return ret;
+            return target;
         }
 
         std::vector<std::pair<int, int>>
         cTourNodes::spanTree_get() const
         {
-            return spanTree.edgeList();
+            return mySpan.g.edgeList();
         }
     }
 }
\ No newline at end of file
@@ -0,0 +1,304 @@
+#include <algorithm>
+#include <chrono>
+#include <deque>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        path_cost_t tourOptimize(
+            const cGraph &g,
+            const std::vector<double> &edgeWeight,
+            const path_t &tour,
+            double seconds)
+        {
+            if (g.isDirected())
+                throw std::runtime_error(
+                    "tourOptimize works only for undirected graphs");
+            if (edgeWeight.size() < g.edgeCount())
+                throw std::runtime_error(
+                    "tourOptimize bad edge weights");
+
+            // candidate neighbours of each vertex, cheapest links only
+            const int neighbours = 8;
+
+            // improvements smaller than this are rounding errors
+            const double epsilon = 1e-9;
+
+            auto stop = std::chrono::steady_clock::now() +
+                        std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                            std::chrono::duration<double>(seconds));
+
+            path_t t(tour);
+            int n = g.vertexCount();
+
+            // a jump between unlinked vertices costs more than any path
+            double jump = 1;
+            for (double w : edgeWeight)
+                jump = std::max(jump, w);
+            jump *= n + 1;
+
+            // cost of link between two vertices
+            auto cost = [&](int u, int v) -> double
+            {
+                if (u == v)
+                    return 0;
+                int ei = g.find(u, v);
+                if (ei < 0)
+                    return jump;
+                return edgeWeight[ei];
+            };
+
+            std::vector<std::vector<int>> vNear(n);
+            std::vector<bool> fNear(n, false);
+            auto nearest = [&](int v) -> const std::vector<int> &
+            {
+                if (!fNear[v])
+                {
+                    auto &near = vNear[v];
+                    near = g.adjacentOutRef(v);
+                    std::sort(
+                        near.begin(), near.end(),
+                        [&](int a, int b)
+                        {
+                            return cost(v, a) < cost(v, b);
+                        });
+                    if (near.size() > neighbours)
+                        near.resize(neighbours);
+                    fNear[v] = true;
+                }
+                return vNear[v];
+            };
+
+            /* tour positions of each vertex, in order, a vertex may be revisited
+
+            A move changes only the positions in a range of the tour,
+            so those are forgotten before the move and recorded again after it
+            */
+            std::vector<std::vector<int>> occurs(n);
+            auto unlocate = [&](int lo, int hi)
+            {
+                for (int p = lo; p < hi; p++)
+                {
+                    auto &o = occurs[t[p]];
+                    o.erase(std::find(o.begin(), o.end(), p));
+                }
+            };
+            auto locate = [&](int lo, int hi)
+            {
+                for (int p = lo; p < hi; p++)
+                {
+                    auto &o = occurs[t[p]];
+                    o.insert(std::lower_bound(o.begin(), o.end(), p), p);
+                }
+            };
+
+            /* don't look bits
+
+            Vertices wait in the queue until no move from them improves the tour.
+            A vertex is queued again when a move changes one of its links.
+            */
+            std::deque<int> active;
+            std::vector<bool> fActive(n, false);
+            auto wake = [&](int v)
+            {
+                if (v < 0 || fActive[v])
+                    return;
+                fActive[v] = true;
+                active.push_back(v);
+            };
+            auto at = [&](int p)
+            {
+                if (p < 0 || p >= t.size())
+                    return -1;
+                return t[p];
+            };
+
+            /* remove a revisit
+
+            When a vertex appears twice, the visit at p can be dropped
+            if its neighbours in the tour are linked more cheaply than through it
+            */
+            auto dropRevisit = [&](int p) -> bool
+            {
+                int v = t[p];
+                if (occurs[v].size() < 2)
+                    return false;
+                int prev = at(p - 1);
+                int next = at(p + 1);
+                double gain;
+                if (prev < 0 || next < 0)
+                    gain = (prev < 0) ? cost(v, next) : cost(prev, v);
+                else
+                    gain = cost(prev, v) + cost(v, next) - cost(prev, next);
+                if (!(gain > epsilon) && prev != v && next != v)
+                    return false;
+                unlocate(p, t.size());
+                t.erase(t.begin() + p);
+                locate(p, t.size());
+                wake(prev);
+                wake(next);
+                return true;
+            };
+
+            /* 2-opt
+
+            Replace the link from the vertex at p to its tour successor
+            with a link to one of its candidate neighbours, reversing the tour between them.
+            The tour is open, so the last link can be dropped instead of replaced.
+            */
+            auto twoOpt = [&](int p) -> bool
+            {
+                int a = t[p];
+                for (int dir : {1, -1})
+                {
+                    int b = at(p + dir);
+                    if (b < 0)
+                        continue;
+                    double ab = cost(a, b);
+                    for (int c : nearest(a))
+                    {
+                        double ac = cost(a, c);
+                        if (ac >= ab)
+                            break;
+                        for (int q : occurs[c])
+                        {
+                            // c must be beyond b, looking from a
+                            if ((q - p) * dir <= 1)
+                                continue;
+                            int d = at(q + dir);
+                            double delta = ac - ab;
+                            if (d >= 0)
+                                delta += cost(b, d) - cost(c, d);
+                            if (!(delta < -epsilon))
+                                continue;
+
+                            int first = std::min(p + dir, q);
+                            int last = std::max(p + dir, q);
+                            unlocate(first, last + 1);
+                            std::reverse(t.begin() + first, t.begin() + last + 1);
+                            locate(first, last + 1);
+                            wake(a);
+                            wake(b);
+                            wake(c);
+                            wake(d);
+                            return true;
+                        }
+                    }
+                }
+                return false;
+            };
+
+            /* Or-opt
+
+            Move a run of up to 3 tour vertices, starting with the vertex at p,
+            next to one of that vertex's candidate neighbours, on either side of it
+            */
+            auto orOpt = [&](int p) -> bool
+            {
+                int a = t[p];
+                for (int len = 1; len <= 3; len++)
+                {
+                    int s = p;
+                    int e = p + len - 1;
+                    if (e >= t.size())
+                        break;
+                    int prev = at(s - 1);
+                    int next = at(e + 1);
+                    int first = t[s];
+                    int last = t[e];
+
+                    // saving from taking the run out
+                    double gain;
+                    if (prev < 0 && next < 0)
+                        break;
+                    if (prev < 0)
+                        gain = cost(last, next);
+                    else if (next < 0)
+                        gain = cost(prev, first);
+                    else
+                        gain = cost(prev, first) + cost(last, next) - cost(prev, next);
+                    if (!(gain > epsilon))
+                        continue;
+
+                    for (int c : nearest(a))
+                        for (int q : occurs[c])
+                            for (int side : {1, -1})
+                            {
+                                // side 1: c, a ... last, y
+                                // side -1: y, last ... a, c
+                                if (side == 1 && q >= s - 1 && q <= e)
+                                    continue;
+                                if (side == -1 && q >= s && q <= e + 1)
+                                    continue;
+                                int y = at(q + side);
+                                double extra = cost(c, a) + cost(last, y);
+                                if (y < 0)
+                                    extra = cost(c, a);
+                                else
+                                    extra -= cost(c, y);
+                                if (!(extra < gain - epsilon))
+                                    continue;
+
+                                // the run lands at ins, so only positions between there and where it was move
+                                int ins = ((q > e) ? q - len : q) + (side == 1 ? 1 : 0);
+                                int lo = std::min(s, ins);
+                                int hi = std::max(e + 1, ins + len);
+                                unlocate(lo, hi);
+                                path_t run(t.begin() + s, t.begin() + e + 1);
+                                if (side == -1)
+                                    std::reverse(run.begin(), run.end());
+                                t.erase(t.begin() + s, t.begin() + e + 1);
+                                t.insert(t.begin() + ins, run.begin(), run.end());
+                                locate(lo, hi);
+                                wake(prev);
+                                wake(next);
+                                wake(c);
+                                wake(y);
+                                for (int v : run)
+                                    wake(v);
+                                return true;
+                            }
+                }
+                return false;
+            };
+
+            locate(0, t.size());
+            for (int v : t)
+                wake(v);
+
+            int checks = 0;
+            while (!active.empty())
+            {
+                // the clock is slow to read, so look only now and then
+                if (seconds > 0 && ++checks % 64 == 0 && std::chrono::steady_clock::now() > stop)
+                    break;
+
+                int v = active.front();
+                active.pop_front();
+                fActive[v] = false;
+
+                bool improved = false;
+                for (int p : occurs[v])
+                {
+                    if (dropRevisit(p) || twoOpt(p) || orOpt(p))
+                    {
+                        improved = true;
+                        break;
+                    }
+                }
+                if (improved)
+                    wake(v);
+            }
+
+            // a move can leave a vertex next to itself
+            t.erase(std::unique(t.begin(), t.end()), t.end());
+
+            double total = 0;
+            for (int p = 1; p < t.size(); p++)
+                total += cost(t[p - 1], t[p]);
+            return std::make_pair(t, total);
+        }
+    }
+}
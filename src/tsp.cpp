@@ -0,0 +1,605 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <thread>
+#include "GraphTheory.h"
+
+namespace raven
+{
+    namespace graph
+    {
+        /// @brief branch and bound search state shared by all threads
+        struct sShared_tsp
+        {
+            int n;
+
+            // flat distance matrix, infinite where there is no link
+            std::vector<double> dist;
+
+            // cheaper direction of each pair
+            std::vector<double> sym;
+
+            // vertices reachable from each vertex, cheapest first
+            std::vector<std::vector<int>> next;
+
+            // least cost an unvisited vertex adds to a tour
+            std::vector<double> spare;
+
+            // least cost of leaving each vertex, the end of a partial tour
+            std::vector<double> leave;
+
+            // least cost of returning to the start
+            double home;
+
+            // best tour found, closed, and its cost
+            std::mutex mtx;
+            std::atomic<double> bestCost;
+            path_t bestPath;
+
+            // time limit, and whether it has passed
+            bool fTimed;
+            std::chrono::steady_clock::time_point stop;
+            std::atomic<bool> fLate;
+
+            /// @brief true once the time limit has passed
+            bool late()
+            {
+                if (fLate.load())
+                    return true;
+                if (fTimed && std::chrono::steady_clock::now() > stop)
+                    fLate = true;
+                return fLate.load();
+            }
+
+            /// @brief costs this close are equal
+            static double tolerance(double cost)
+            {
+                return 1e-9 * (1 + std::abs(cost));
+            }
+
+            /// @brief lower bound on the cost of any tour starting with a partial tour
+            double bound(int last, double cost, double rest) const
+            {
+                return cost + rest + leave[last] + home;
+            }
+
+            /// @brief true if no tour starting with this partial tour can be chosen
+            ///
+            /// A tour costing the same as the best is chosen if it comes first in vertex order,
+            /// so every thread count gives the same result
+
+            bool prune(const path_t &path, double lowerBound)
+            {
+                double best = bestCost.load();
+                if (best == std::numeric_limits<double>::infinity())
+                    return false;
+                double tol = tolerance(best);
+                if (lowerBound < best - tol)
+                    return false;
+                if (lowerBound > best + tol)
+                    return true;
+
+                // a tie at best, prune if the best tour comes first
+                std::lock_guard<std::mutex> lock(mtx);
+                return std::lexicographical_compare(
+                    bestPath.begin(), bestPath.begin() + std::min(path.size(), bestPath.size()),
+                    path.begin(), path.end());
+            }
+
+            /// @brief offer a closed tour
+            void offer(const path_t &path, double cost)
+            {
+                std::lock_guard<std::mutex> lock(mtx);
+                double best = bestCost.load();
+                bool fFirst = (best == std::numeric_limits<double>::infinity());
+                double tol = fFirst ? 0 : tolerance(best);
+                if (fFirst ||
+                    cost < best - tol ||
+                    (cost <= best + tol && path < bestPath))
+                {
+                    bestPath = path;
+                    bestCost = cost;
+                }
+            }
+        };
+
+        /// @brief search state of one thread
+        struct sWork_tsp
+        {
+            path_t path;
+            std::vector<char> visited;
+
+            // partial tours searched, the clock is slow to read so look only now and then
+            int nodes = 0;
+
+            // spanning tree workspace
+            std::vector<int> members;
+            std::vector<double> key;
+        };
+
+        /// @brief lower bound on the cost of the rest of a tour
+        ///
+        /// The rest of the tour leaves the end of the partial tour for an unvisited vertex,
+        /// follows a path through the unvisited vertices, then returns to the start.
+        /// The path costs at least as much as a minimum spanning tree of the unvisited vertices.
+
+        static double restTree_tsp(
+            const sShared_tsp &S,
+            sWork_tsp &W)
+        {
+            const double none = std::numeric_limits<double>::infinity();
+            int last = W.path.back();
+            int start = W.path[0];
+            auto &members = W.members;
+            members.clear();
+            double out = none, in = none;
+            for (int v = 0; v < S.n; v++)
+                if (!W.visited[v])
+                {
+                    members.push_back(v);
+                    out = std::min(out, S.dist[last * S.n + v]);
+                    in = std::min(in, S.dist[v * S.n + start]);
+                }
+            if (members.empty())
+                return S.dist[last * S.n + start];
+
+            // Prim, dense
+            int m = members.size();
+            auto &key = W.key;
+            key.assign(m, none);
+            key[0] = 0;
+            double total = out + in;
+            int k = 0;
+            for (int added = 0; added < m; added++)
+            {
+                // take vertex k into the tree, swapping it to the front of those still outside
+                std::swap(members[added], members[k]);
+                std::swap(key[added], key[k]);
+                total += key[added];
+                if (total == none)
+                    return none;
+                int v = members[added];
+                k = -1;
+                for (int j = added + 1; j < m; j++)
+                {
+                    double d = S.sym[v * S.n + members[j]];
+                    if (d < key[j])
+                        key[j] = d;
+                    if (k < 0 || key[j] < key[k])
+                        k = j;
+                }
+            }
+            return total;
+        }
+
+        /// @brief search every tour that starts with a partial tour
+        /// @param S shared state
+        /// @param W thread search state, W.path partial tour, extended and restored
+        /// @param cost of partial tour
+        /// @param rest sum of spare for unvisited vertices
+
+        static void branch_tsp(
+            sShared_tsp &S,
+            sWork_tsp &W,
+            double cost,
+            double rest)
+        {
+            auto &path = W.path;
+            auto &visited = W.visited;
+            if (++W.nodes % 1024 == 0 && S.late())
+                return;
+            int v = path.back();
+            if (path.size() == S.n)
+            {
+                double back = S.dist[v * S.n + path[0]];
+                if (back == std::numeric_limits<double>::infinity())
+                    return;
+                path.push_back(path[0]);
+                S.offer(path, cost + back);
+                path.pop_back();
+                return;
+            }
+            for (int u : S.next[v])
+            {
+                if (visited[u])
+                    continue;
+                double c = cost + S.dist[v * S.n + u];
+                double r = rest - S.spare[u];
+                path.push_back(u);
+                visited[u] = 1;
+
+                // the spanning tree bound is stronger, but slower
+                if (!S.prune(path, S.bound(u, c, r)) &&
+                    !S.prune(path, c + restTree_tsp(S, W)))
+                    branch_tsp(S, W, c, r);
+
+                visited[u] = 0;
+                path.pop_back();
+                if (S.fLate.load())
+                    return;
+            }
+        }
+
+        cTSP::cTSP(raven::graph::cGraph &inputGraph,
+                   const std::vector<double> &vEdgeWeight)
+            : final_res(INT_MAX),
+              myN(inputGraph.vertexCount()),
+              myDirected(inputGraph.isDirected())
+        {
+            if (vEdgeWeight.size() < inputGraph.edgeCount())
+                throw std::runtime_error(
+                    "cTSP bad edge weights");
+
+            // infinite where there is no link
+            myDist.resize(myN * myN, std::numeric_limits<double>::infinity());
+            for (int v = 0; v < myN; v++)
+                for (int w : inputGraph.adjacentOutRef(v))
+                    if (v != w)
+                        myDist[v * myN + w] = vEdgeWeight[inputGraph.find(v, w)];
+        }
+
+        cTSP::cTSP(const cEuclideanGraph &cities)
+            : final_res(INT_MAX),
+              myN(cities.vertexCount()),
+              myDirected(false)
+        {
+            myDist.resize(myN * myN);
+            std::vector<double> row;
+            for (int v = 0; v < myN; v++)
+            {
+                cities.edgeWeights(v, row);
+                std::copy(row.begin(), row.end(), myDist.begin() + v * myN);
+
+                // no link from a city to itself
+                myDist[v * myN + v] = std::numeric_limits<double>::infinity();
+            }
+        }
+
+        std::vector<int> cTSP::calculate(int threads, double seconds)
+        {
+            final_path.clear();
+            final_res = INT_MAX;
+            int n = myN;
+            if (n < 2)
+                return final_path;
+
+            const double none = std::numeric_limits<double>::infinity();
+
+            sShared_tsp S;
+            S.n = n;
+            S.dist = myDist;
+            S.fTimed = seconds > 0;
+            S.stop = std::chrono::steady_clock::now() +
+                     std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                         std::chrono::duration<double>(seconds));
+            S.fLate = false;
+
+            S.sym.resize(n * n);
+            for (int v = 0; v < n; v++)
+                for (int w = 0; w < n; w++)
+                    S.sym[v * n + w] = std::min(S.dist[v * n + w], S.dist[w * n + v]);
+
+            S.next.resize(n);
+            for (int v = 0; v < n; v++)
+            {
+                for (int w = 0; w < n; w++)
+                    if (S.dist[v * n + w] != none)
+                        S.next[v].push_back(w);
+                std::stable_sort(
+                    S.next[v].begin(), S.next[v].end(),
+                    [&](int a, int b)
+                    {
+                        return S.dist[v * n + a] < S.dist[v * n + b];
+                    });
+            }
+
+            /* lower bound on the cost of finishing a tour
+
+            Every unvisited vertex will have a link in and a link out,
+            the end of the partial tour a link out and the start a link in.
+            An undirected link serves both its ends, so each end is charged half
+            of its two cheapest links. A directed link is charged to its source.
+            */
+            std::vector<double> first(n, none), second(n, none), firstIn(n, none);
+            for (int v = 0; v < n; v++)
+                for (int w : S.next[v])
+                {
+                    double d = S.dist[v * n + w];
+                    if (d < first[v])
+                    {
+                        second[v] = first[v];
+                        first[v] = d;
+                    }
+                    else if (d < second[v])
+                        second[v] = d;
+                    firstIn[w] = std::min(firstIn[w], d);
+                }
+            if (n == 2)
+            {
+                // both ways round the same link
+                second = first;
+            }
+            S.spare.resize(n);
+            S.leave.resize(n);
+            for (int v = 0; v < n; v++)
+            {
+                if (myDirected)
+                {
+                    S.spare[v] = first[v];
+                    S.leave[v] = first[v];
+                }
+                else
+                {
+                    S.spare[v] = (first[v] + second[v]) / 2;
+                    S.leave[v] = first[v] / 2;
+                }
+            }
+            S.home = myDirected ? 0 : first[0] / 2;
+            double rest = 0;
+            for (int v = 1; v < n; v++)
+                rest += S.spare[v];
+            if (rest == none || S.home == none || S.leave[0] == none || firstIn[0] == none)
+                return final_path;
+
+            // nearest neighbour tour, improved by 2-opt, as a starting bound
+            S.bestCost = none;
+            {
+                path_t path{0};
+                std::vector<char> visited(n, 0);
+                visited[0] = 1;
+                double cost = 0;
+                while (path.size() < n)
+                {
+                    int v = path.back();
+                    int u = -1;
+                    for (int w : S.next[v])
+                        if (!visited[w])
+                        {
+                            u = w;
+                            break;
+                        }
+                    if (u < 0)
+                        break;
+                    cost += S.dist[v * n + u];
+                    visited[u] = 1;
+                    path.push_back(u);
+                }
+                if (path.size() == n && S.dist[path.back() * n] != none)
+                {
+                    cost += S.dist[path.back() * n];
+                    path.push_back(0);
+
+                    // 2-opt, the tour can be reversed between two links if undirected
+                    bool improved = !myDirected;
+                    while (improved)
+                    {
+                        improved = false;
+                        for (int i = 0; i + 2 < n; i++)
+                            for (int j = i + 2; j < n; j++)
+                            {
+                                int a = path[i], b = path[i + 1], c = path[j], d = path[j + 1];
+                                double delta = S.dist[a * n + c] + S.dist[b * n + d] -
+                                               S.dist[a * n + b] - S.dist[c * n + d];
+                                if (delta < -sShared_tsp::tolerance(cost))
+                                {
+                                    std::reverse(path.begin() + i + 1, path.begin() + j + 1);
+                                    cost += delta;
+                                    improved = true;
+                                }
+                            }
+                    }
+                    S.bestPath = path;
+                    S.bestCost = cost;
+                }
+            }
+
+            // tours shorter than this are searched on the calling thread alone
+            const int parallelVertices = 12;
+
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+            if (threads <= 1 || n < parallelVertices)
+                threads = 1;
+
+            /* split the search into subtrees, partial tours of a few vertices,
+            enough that the threads stay busy as the subtrees are handed out
+            */
+            struct sTask
+            {
+                path_t path;
+                double cost;
+                double rest;
+            };
+            std::vector<sTask> vTask{{{0}, 0, rest}};
+            while (threads > 1 &&
+                   vTask.size() < 16 * threads &&
+                   vTask[0].path.size() < n - 1)
+            {
+                std::vector<sTask> deeper;
+                for (auto &t : vTask)
+                {
+                    int v = t.path.back();
+                    for (int u : S.next[v])
+                    {
+                        if (std::find(t.path.begin(), t.path.end(), u) != t.path.end())
+                            continue;
+                        sTask d{t.path, t.cost + S.dist[v * n + u], t.rest - S.spare[u]};
+                        d.path.push_back(u);
+                        if (!S.prune(d.path, S.bound(u, d.cost, d.rest)))
+                            deeper.push_back(d);
+                    }
+                }
+                if (deeper.empty())
+                {
+                    vTask.clear();
+                    break;
+                }
+                vTask.swap(deeper);
+            }
+
+            std::atomic<int> nextTask(0);
+            auto work = [&]()
+            {
+                sWork_tsp W;
+                W.visited.resize(n);
+                while (true)
+                {
+                    int k = nextTask++;
+                    if (k >= vTask.size() || S.late())
+                        return;
+                    auto &t = vTask[k];
+                    if (S.prune(t.path, S.bound(t.path.back(), t.cost, t.rest)))
+                        continue;
+                    std::fill(W.visited.begin(), W.visited.end(), 0);
+                    for (int v : t.path)
+                        W.visited[v] = 1;
+                    W.path = t.path;
+                    branch_tsp(S, W, t.cost, t.rest);
+                }
+            };
+            if (threads == 1)
+                work();
+            else
+            {
+                std::vector<std::thread> vThread;
+                for (int k = 0; k < threads; k++)
+                    vThread.emplace_back(work);
+                for (auto &t : vThread)
+                    t.join();
+            }
+
+            // out of time, the best tour found may not be the cheapest
+            if (S.fLate.load() || S.bestCost.load() == none)
+                return final_path;
+            final_path = S.bestPath;
+            final_res = std::round(S.bestCost.load());
+            return final_path;
+        }
+
+        std::vector<int> cTSP::calculateHeldKarp(int threads)
+        {
+            // a table entry for every subset of the other cities, at each city
+            const int maxCities = 20;
+
+            final_path.clear();
+            final_res = INT_MAX;
+            int n = myN;
+            if (n < 2)
+                return final_path;
+            if (n > maxCities)
+                throw std::runtime_error(
+                    "cTSP Held-Karp too many cities");
+            if (threads <= 0)
+                threads = std::thread::hardware_concurrency();
+
+            const double none = std::numeric_limits<double>::infinity();
+            const auto &dist = myDist;
+
+            // the tour starts at vertex 0, bit j of a subset is vertex j + 1
+            int m = n - 1;
+            int subsets = 1 << m;
+
+            // link costs into each vertex, so the inner loop reads memory in order
+            std::vector<double> arrive(m * m);
+            for (int j = 0; j < m; j++)
+                for (int i = 0; i < m; i++)
+                    arrive[j * m + i] = dist[(i + 1) * n + j + 1];
+
+            /* cheapest path from vertex 0 through every vertex in a subset, ending at j
+
+            cost[subset * m + j], infinite when j is not in the subset
+            */
+            std::vector<double> cost((size_t)subsets * m, none);
+            for (int j = 0; j < m; j++)
+                cost[(1 << j) * m + j] = dist[j + 1];
+
+            // cheapest way to reach j through the rest of subset
+            auto through = [&](int subset, int j) -> double
+            {
+                const double *before = &cost[(size_t)(subset ^ (1 << j)) * m];
+                const double *in = &arrive[j * m];
+                double best = none;
+                for (int i = 0; i < m; i++)
+                    best = std::min(best, before[i] + in[i]);
+                return best;
+            };
+
+            // fewer subsets than this in a layer are done by the calling thread alone
+            const int parallelSubsets = 1000;
+
+            // subsets one vertex larger need only the previous layer, so each layer is shared between threads
+            std::vector<int> layer;
+            for (int size = 2; size <= m; size++)
+            {
+                // every subset of this size, in increasing order
+                layer.clear();
+                for (int subset = (1 << size) - 1; subset < subsets;)
+                {
+                    layer.push_back(subset);
+                    int low = subset & -subset;
+                    int carry = subset + low;
+                    subset = (((carry ^ subset) >> 2) / low) | carry;
+                }
+                share(
+                    layer.size(), threads,
+                    [&](int first, int last, int t)
+                    {
+                        for (int k = first; k < last; k++)
+                        {
+                            int subset = layer[k];
+                            for (int j = 0; j < m; j++)
+                                if (subset & (1 << j))
+                                    cost[(size_t)subset * m + j] = through(subset, j);
+                        }
+                    },
+                    parallelSubsets);
+            }
+
+            // close the tour, ties to the lowest vertex
+            int all = subsets - 1;
+            double best = none;
+            int last = -1;
+            for (int j = 0; j < m; j++)
+            {
+                double c = cost[(size_t)all * m + j] + dist[(j + 1) * n];
+                if (c < best)
+                {
+                    best = c;
+                    last = j;
+                }
+            }
+            if (last < 0)
+                return final_path;
+
+            // walk back through the table
+            final_path.push_back(0);
+            int subset = all;
+            for (int j = last; j >= 0;)
+            {
+                final_path.push_back(j + 1);
+                int before = subset ^ (1 << j);
+                int i = -1;
+                if (before)
+                {
+                    double c = cost[(size_t)subset * m + j];
+                    for (i = 0; i < m; i++)
+                        if (cost[(size_t)before * m + i] + arrive[j * m + i] == c)
+                            break;
+                }
+                subset = before;
+                j = i;
+            }
+            final_path.push_back(0);
+
+            // an undirected tour can go either way round, start towards the lower neighbour
+            if (myDirected || final_path[1] > final_path[n - 1])
+                std::reverse(final_path.begin(), final_path.end());
+
+            final_res = std::round(best);
+            return final_path;
+        }
+    }
+}